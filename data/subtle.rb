@@ -38,6 +38,10 @@ set :honor_size_hints, false
 # Enable gravity tiling for all gravities
 set :gravity_tiling, false
 
+# Move and resize windows directly instead of drawing a frame, this doesn't
+# freeze other windows while dragging
+set :opaque_drag, false
+
 # Enable click-to-focus focus model
 set :click_to_focus, false
 
@@ -47,6 +51,16 @@ set :skip_pointer_warp, false
 # Skip pointer movement to urgent windows
 set :skip_urgent_warp, false
 
+# Spread sublets with same interval instead of updating all at once
+set :spread_sublets, false
+
+# Drop queued client messages for windows/views that don't appear in seconds,
+# 0 keeps them until the queue is full
+set :queue_expiry, 10
+
+# Warn about sublets, hooks and events that block subtle longer than this (ms)
+set :stall_budget, 1000
+
 # Set the WM_NAME of subtle (Java quirk)
 # set :wmname, "LG3D"
 
@@ -399,6 +413,9 @@ grab "W-Down",  :WindowDown
 grab "W-Up",    :WindowUp
 grab "W-Right", :WindowRight
 
+# Cycle through recently focused windows of the current view
+grab "W-Tab", :WindowRecent
+
 # Kill current window
 grab "W-S-k", :WindowKill
 
@@ -715,6 +732,13 @@ end
 #
 #                Example: icon_only true
 #
+# [*layout*]     This property tiles all windows of the view with a built-in
+#                layout instead of gravities. Floating, fullscreen, desktop
+#                and dock windows are left alone. Available layouts are
+#                :master, :grid, :spiral and :columns.
+#
+#                Example: layout :master
+#
 #
 # === Link
 #
@@ -745,7 +769,7 @@ view "dev",   "editor"
 #
 # There are three default properties, that can be be changed for every sublet:
 #
-# [*interval*]    Update interval of the sublet
+# [*interval*]    Update interval of the sublet in seconds (e.g. 0.25)
 # [*foreground*]  Default foreground color
 # [*background*]  Default background color
 #
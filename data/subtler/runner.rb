@@ -72,6 +72,7 @@ module Subtle # {{{
           [ '--reload',  '-r', GetoptLong::NO_ARGUMENT       ],
           [ '--restart', '-R', GetoptLong::NO_ARGUMENT       ],
           [ '--quit',    '-q', GetoptLong::NO_ARGUMENT       ],
+          [ '--stats',   '-P', GetoptLong::NO_ARGUMENT       ],
           [ '--current', '-C', GetoptLong::NO_ARGUMENT       ],
           [ '--select',  '-X', GetoptLong::NO_ARGUMENT       ],
           [ '--proc',    '-p', GetoptLong::REQUIRED_ARGUMENT ],
@@ -127,6 +128,7 @@ module Subtle # {{{
             when '--reload'  then @mod = :reload
             when '--restart' then @mod = :restart
             when '--quit'    then @mod = :quit
+            when '--stats'   then @mod = :stats
             when '--current' then @mod = :current
             when '--select'  then @mod = :select
 
@@ -180,6 +182,7 @@ module Subtle # {{{
           when :reload  then  Subtlext::Subtle.reload
           when :restart then  Subtlext::Subtle.restart
           when :quit    then  Subtlext::Subtle.quit
+          when :stats   then  print_stats(Subtlext::Subtle.stats)
           when :current
             arg2 = arg1
             arg1 = :current
@@ -239,7 +242,7 @@ module Subtle # {{{
                   handle_result(obj.send(@action))
                 end
             end
-          elsif :reload != @mod and :restart != @mod and :quit != @mod
+          elsif not [ :reload, :restart, :quit, :stats ].include?(@mod)
             usage(@group)
             exit
           end
@@ -257,6 +260,29 @@ module Subtle # {{{
         end
       end # }}}
 
+      def print_stats(stats) # {{{
+        puts '%-20s %8s %10s %10s %10s %10s' % [
+          'TYPE', 'COUNT', 'AVG(us)', 'P50(us)', 'P99(us)', 'MAX(us)'
+        ]
+
+        stats.sort_by { |name, row| -row[:total] }.each do |name, row|
+          # Upper bucket bounds of percentiles
+          p50 = p99 = nil
+          sum = 0
+
+          row[:buckets].each_with_index do |n, i|
+            sum += n
+            p50 ||= 2 ** (i + 1) if sum * 2   >= row[:count]
+            p99 ||= 2 ** (i + 1) if sum * 100 >= row[:count] * 99
+          end
+
+          puts '%-20s %8d %10d %10s %10s %10d' % [
+            name, row[:count], row[:total] / [ row[:count], 1 ].max,
+            '<%d' % p50, '<%d' % p99, row[:max]
+          ]
+        end
+      end # }}}
+
       def handle_result(result) # {{{
         case result
           when Array
@@ -341,6 +367,7 @@ module Subtle # {{{
     -r, --reload           Reload config and sublets
     -R, --restart          Restart subtle
     -q, --quit             Quit subtle
+    -P, --stats            Show event loop latency stats of subtle
     -C, --current          Select current active window/view
                            instead of passing it via argument
     -X, --select           Select a window via pointer instead
@@ -12,6 +12,21 @@
 
 #include "subtle.h"
 
+/* ArrayReindex {{{ */
+static void
+ArrayReindex(SubArray *a,
+  int from)
+{
+  int i;
+
+  /* Update stored index of moved elements */
+  if(a->indexed)
+    for(i = from; i < a->ndata; i++)
+      ELEM(a->data[i])->idx = i;
+} /* }}} */
+
+/* Public */
+
  /** subArrayNew {{{
   * @brief Create new array and init it
   * @return Returns a #SubArray or \p NULL
@@ -39,6 +54,8 @@ subArrayPush(SubArray *a,
     {
       a->data = (void **)subSharedMemoryRealloc(a->data, (a->ndata + 1) * sizeof(void *));
       a->data[(a->ndata)++] = elem;
+
+      ArrayReindex(a, a->ndata - 1);
     }
 } /* }}} */
 
@@ -68,6 +85,8 @@ subArrayInsert(SubArray *a,
         a->data[i] = a->data[i - 1];
 
       a->data[pos] = elem;
+
+      ArrayReindex(a, pos);
     }
   else subArrayPush(a, elem);
 } /* }}} */
@@ -93,6 +112,8 @@ subArrayRemove(SubArray *a,
 
       a->ndata--;
       a->data = (void **)subSharedMemoryRealloc(a->data, a->ndata * sizeof(void *));
+
+      ArrayReindex(a, idx);
     }
 } /* }}} */
 
@@ -127,6 +148,11 @@ subArrayIndex(SubArray *a,
 
   assert(a && elem);
 
+  /* Use stored index when element is still there */
+  if(a->indexed && 0 <= (i = ELEM(elem)->idx) && i < a->ndata &&
+      a->data[i] == elem)
+    return i;
+
   for(i = 0; i < a->ndata; i++)
     if(a->data[i] == elem) return i;
 
@@ -146,6 +172,8 @@ subArraySort(SubArray *a,
   assert(a && compar);
 
   if(0 < a->ndata) qsort(a->data, a->ndata, sizeof(void *), compar);
+
+  ArrayReindex(a, 0);
 } /* }}} */
 
  /** subArrayClear {{{
@@ -10,9 +10,14 @@
   * See the file COPYING for details.
   **/
 
+#include <sys/poll.h>
 #include <X11/Xatom.h>
 #include "subtle.h"
 
+#ifdef HAVE_X11_XLIB_XCB_H
+#include <X11/Xlib-xcb.h>
+#endif /* HAVE_X11_XLIB_XCB_H */
+
 /* Flags {{{ */
 #define EDGE_LEFT   (1L << 0)
 #define EDGE_RIGHT  (1L << 1)
@@ -20,6 +25,8 @@
 #define EDGE_BOTTOM (1L << 3)
 /* }}} */
 
+#define DRAGRATE 16                              ///< Min ms between opaque drag updates
+
 /* Typedef {{{ */
 typedef struct clientmwmhints_t
 {
@@ -29,10 +36,205 @@ typedef struct clientmwmhints_t
   long input_mode;
   unsigned long status;
 } ClientMWMHints;
+
+#define NPREFETCH 13                             ///< Number of prefetched properties
+
+typedef struct clientprefetch_t
+{
+  Atom          prop, type;                      ///< Prefetch property and type
+  unsigned long nitems, bytes;                   ///< Prefetch items and size
+  char          *data;                           ///< Prefetch data in Xlib layout
+} ClientPrefetch;
+
+typedef struct clientprefetchwin_t
+{
+  Window            win;                         ///< Prefetch window
+  XWindowAttributes attrs;                       ///< Prefetch window attributes
+  ClientPrefetch    props[NPREFETCH];            ///< Prefetch properties
+} ClientPrefetchWin;
 /* }}} */
 
+/* Globals */
+ClientPrefetchWin *prefetches = NULL;
+SubArray **members = NULL;
+Window *stacked = NULL, *cycle = NULL;
+SubClient *mruhead = NULL, *mrutail = NULL;
+SubClient **spatialx = NULL, **spatialy = NULL;
+TAGS spatialtags = 0;
+int nspatial = 0, spatialdirty = True;
+int nprefetches = 0, nmembers = 0, nmembergravities = 0;
+int membersdirty = True, nstacked = 0, ncycle = 0, cyclepos = 0;
+
 /* Private */
 
+#ifdef HAVE_X11_XLIB_XCB_H
+/* ClientPrefetchStore {{{ */
+static void
+ClientPrefetchStore(ClientPrefetch *p,
+  xcb_get_property_reply_t *reply)
+{
+  int i;
+  void *value = xcb_get_property_value(reply);
+
+  p->type   = reply->type;
+  p->nitems = reply->value_len;
+
+  /* Convert to Xlib layout: long for 32, short for 16 and
+   * terminated char for 8 bit data */
+  switch(reply->format)
+    {
+      case 32:
+        p->bytes = p->nitems * sizeof(long);
+        p->data  = (char *)subSharedMemoryAlloc(p->nitems + 1, sizeof(long));
+
+        for(i = 0; i < p->nitems; i++)
+          ((long *)p->data)[i] = ((uint32_t *)value)[i];
+        break;
+      case 16:
+        p->bytes = p->nitems * sizeof(short);
+        p->data  = (char *)subSharedMemoryAlloc(p->nitems + 1, sizeof(short));
+
+        for(i = 0; i < p->nitems; i++)
+          ((short *)p->data)[i] = ((uint16_t *)value)[i];
+        break;
+      default:
+        p->bytes = p->nitems;
+        p->data  = (char *)subSharedMemoryAlloc(p->nitems + 1, sizeof(char));
+
+        memcpy(p->data, value, p->nitems);
+    }
+} /* }}} */
+#endif /* HAVE_X11_XLIB_XCB_H */
+
+/* ClientPrefetchFind {{{ */
+static ClientPrefetchWin *
+ClientPrefetchFind(Window win)
+{
+  int i;
+
+  for(i = 0; i < nprefetches; i++)
+    if(prefetches[i].win == win) return &prefetches[i];
+
+  return NULL;
+} /* }}} */
+
+/* ClientPrefetchDrop {{{ */
+static void
+ClientPrefetchDrop(ClientPrefetchWin *p)
+{
+  int i;
+
+  for(i = 0; i < NPREFETCH; i++)
+    if(p->props[i].data) free(p->props[i].data);
+
+  /* Fill gap with last entry */
+  *p = prefetches[--nprefetches];
+
+  if(0 == nprefetches)
+    {
+      free(prefetches);
+      prefetches = NULL;
+    }
+} /* }}} */
+
+/* ClientProperty {{{ */
+static char *
+ClientProperty(SubClient *c,
+  Atom type,
+  Atom prop,
+  unsigned long *size)
+{
+  ClientPrefetchWin *p = NULL;
+
+  /* Use prefetched properties during adoption */
+  if((p = ClientPrefetchFind(c->win)))
+    {
+      int i;
+
+      for(i = 0; i < NPREFETCH; i++)
+        {
+          ClientPrefetch *pp = &p->props[i];
+
+          if(None != pp->prop && pp->prop == prop)
+            {
+              char *data = NULL;
+
+              if(type != pp->type || !pp->data) return NULL;
+
+              data = (char *)subSharedMemoryAlloc(pp->bytes + sizeof(long), 1);
+              memcpy(data, pp->data, pp->bytes);
+
+              if(size) *size = pp->nitems;
+
+              return data;
+            }
+        }
+    }
+
+  return subSharedPropertyGet(subtle->dpy, c->win, type, prop, size);
+} /* }}} */
+
+/* ClientClass {{{ */
+static void
+ClientClass(SubClient *c)
+{
+  unsigned long size = 0;
+  char *klass = NULL;
+
+  /* WM_CLASS contains instance and class separated by \0 */
+  if((klass = ClientProperty(c, XA_STRING, XA_WM_CLASS, &size)))
+    {
+      int len = strnlen(klass, size);
+
+      c->instance = subStringIntern(0 < len ? klass : "subtle");
+      c->klass    = subStringIntern(len + 1 < size ? klass + len + 1 : "subtle");
+
+      free(klass);
+    }
+  else
+    {
+      c->instance = subStringIntern("subtle");
+      c->klass    = subStringIntern("subtle");
+    }
+} /* }}} */
+
+/* ClientRole {{{ */
+static void
+ClientRole(SubClient *c)
+{
+  char *role = NULL;
+
+  /* Roles are shared like WM_CLASS */
+  if((role = ClientProperty(c, XA_STRING,
+      subEwmhGet(SUB_EWMH_WM_WINDOW_ROLE), NULL)))
+    {
+      c->role = subStringIntern(role);
+
+      free(role);
+    }
+} /* }}} */
+
+/* ClientName {{{ */
+static void
+ClientName(SubClient *c)
+{
+  unsigned long size = 0;
+  char *name = NULL;
+
+  /* Plain names can be used as is, leave the rest to Xlib */
+  if(ClientPrefetchFind(c->win) &&
+      ((name = ClientProperty(c, subEwmhGet(SUB_EWMH_UTF8),
+        subEwmhGet(SUB_EWMH_NET_WM_NAME), &size)) ||
+      (name = ClientProperty(c, XA_STRING, XA_WM_NAME, &size))) &&
+      0 < size)
+    {
+      c->name = strdup(name);
+    }
+  else subSharedPropertyName(subtle->dpy, c->win, &c->name, c->klass);
+
+  if(name) free(name);
+} /* }}} */
+
 /* ClientMask {{{ */
 static void
 ClientMask(XRectangle *geom)
@@ -41,6 +243,38 @@ ClientMask(XRectangle *geom)
     geom->width + 1, geom->height + 1);
 } /* }}} */
 
+/* ClientDragWait {{{ */
+static int
+ClientDragWait(unsigned long last)
+{
+  long remain = (long)(last + DRAGRATE * 1000 - subStatsTime()) / 1000;
+  struct pollfd pfd;
+
+  /* Wait for new data on the connection until the next update is due */
+  pfd.fd     = ConnectionNumber(subtle->dpy);
+  pfd.events = POLLIN;
+
+  return 0 < poll(&pfd, 1, MAX(0, remain));
+} /* }}} */
+
+/* ClientDragApply {{{ */
+static void
+ClientDragApply(SubClient *c,
+  XRectangle *geom)
+{
+  c->geom = *geom;
+
+  /* Subtract border width */
+  if(!(c->flags & SUB_CLIENT_MODE_BORDERLESS))
+    {
+      c->geom.x -= subtle->styles.clients.border.top;
+      c->geom.y -= subtle->styles.clients.border.top;
+    }
+
+  subClientMoveResize(c, &c->geom);
+  XFlush(subtle->dpy);
+} /* }}} */
+
 /* ClientGravity {{{ */
 int
 ClientGravity(void)
@@ -163,8 +397,104 @@ ClientResize(SubClient *c,
     subtle->styles.clients.margin.bottom);
 
   subClientResize(c, bounds, True);
-  XMoveResizeWindow(subtle->dpy, c->win, c->geom.x, c->geom.y,
-    c->geom.width, c->geom.height);
+  subClientMoveResize(c, &c->geom);
+} /* }}} */
+
+/* ClientMembersId {{{ */
+static int
+ClientMembersId(SubClient *c)
+{
+  /* Only visible tiled clients are members of a screen and gravity */
+  if(0 <= c->gravityid && c->gravityid < nmembergravities &&
+      0 <= c->screenid && c->screenid < subtle->screens->ndata &&
+      subtle->visible_tags & c->tags &&
+      !(c->flags & (SUB_CLIENT_DEAD|SUB_CLIENT_MODE_FLOAT|
+        SUB_CLIENT_MODE_FULL)) &&
+      -1 != subArrayIndex(subtle->clients, (void *)c))
+    return c->screenid * nmembergravities + c->gravityid;
+
+  return -1;
+} /* }}} */
+
+/* ClientMembersInsert {{{ */
+static void
+ClientMembersInsert(SubArray *list,
+  SubClient *c)
+{
+  int lo = 0, hi = list->ndata, idx = subArrayIndex(subtle->clients, (void *)c);
+
+  /* Keep client list order */
+  while(lo < hi)
+    {
+      int mid = (lo + hi) / 2;
+
+      if(subArrayIndex(subtle->clients, list->data[mid]) < idx) lo = mid + 1;
+      else hi = mid;
+    }
+
+  subArrayInsert(list, lo, (void *)c);
+} /* }}} */
+
+/* ClientMembersRebuild {{{ */
+static void
+ClientMembersRebuild(void)
+{
+  int i;
+
+  /* Resize member lists for current screens and gravities */
+  for(i = 0; i < nmembers; i++)
+    subArrayKill(members[i], False);
+
+  if(members) free(members);
+
+  nmembergravities = subtle->gravities->ndata;
+  nmembers         = subtle->screens->ndata * nmembergravities;
+  members          = (SubArray **)subSharedMemoryAlloc(nmembers + 1,
+    sizeof(SubArray *));
+
+  for(i = 0; i < nmembers; i++)
+    members[i] = subArrayNew();
+
+  /* Assign clients in client list order */
+  for(i = 0; i < subtle->clients->ndata; i++)
+    {
+      SubClient *c = CLIENT(subtle->clients->data[i]);
+
+      if(-1 != (c->memberid = ClientMembersId(c)))
+        subArrayPush(members[c->memberid], (void *)c);
+    }
+
+  membersdirty = False;
+
+  subSubtleLogDebugSubtle("MembersRebuild: clients=%d, lists=%d\n",
+    subtle->clients->ndata, nmembers);
+} /* }}} */
+
+/* ClientMembersValid {{{ */
+static int
+ClientMembersValid(void)
+{
+  /* Lists are invalid when screens or gravities changed */
+  return !membersdirty && nmembergravities == subtle->gravities->ndata &&
+    nmembers == subtle->screens->ndata * nmembergravities;
+} /* }}} */
+
+/* ClientMembersSync {{{ */
+static void
+ClientMembersSync(SubClient *c,
+  int moved)
+{
+  int id = -1;
+
+  /* Next use rebuilds anyway */
+  if(!ClientMembersValid()) return;
+
+  if((id = ClientMembersId(c)) == c->memberid && !moved) return;
+
+  /* Move client to new list in client order */
+  if(-1 != c->memberid) subArrayRemove(members[c->memberid], (void *)c);
+
+  if(-1 != (c->memberid = id)) ClientMembersInsert(members[id], c);
 } /* }}} */
 
 /* ClientTile {{{ */
@@ -174,20 +504,22 @@ ClientTile(int gravity,
 {
   int i, used = 0, pos = 0, calc = 0, fix = 0;
   XRectangle geom = { 1 };
+  SubArray *list = NULL;
   SubScreen *s = SCREEN(subArrayGet(subtle->screens, screen));
   SubGravity *g = GRAVITY(subArrayGet(subtle->gravities, gravity));
 
-  /* Pass 1: Count clients with this gravity */
-  for(i = 0; i < subtle->clients->ndata; i++)
-    {
-      SubClient *c = CLIENT(subtle->clients->data[i]);
+  if(!s || !g) return;
 
-      if(c->gravityid == gravity && c->screenid == screen &&
-        subtle->visible_tags & c->tags &&
-        !(c->flags &(SUB_CLIENT_MODE_FLOAT|SUB_CLIENT_MODE_FULL))) used++;
-    }
+  /* Views with a layout tile the whole screen at once */
+  if(subLayoutDirty(screen)) return;
 
-  if(0 == used || !s || !g) return;
+  /* Only members of this screen and gravity are affected */
+  if(!ClientMembersValid()) ClientMembersRebuild();
+
+  list = members[screen * nmembergravities + gravity];
+
+  /* Lists only contain visible tiled clients */
+  if(0 == (used = list->ndata)) return;
 
   /* Calculate tiled gravity value and rounding fix */
   subGravityGeometry(g, &(s->geom), &geom);
@@ -204,31 +536,26 @@ ClientTile(int gravity,
     }
 
   /* Pass 2: Update geometry of every client with this gravity */
-  for(i = 0; i < subtle->clients->ndata; i++)
+  for(i = 0; i < list->ndata; i++)
     {
-      SubClient *c = CLIENT(subtle->clients->data[i]);
+      SubClient *c = CLIENT(list->data[i]);
 
-      if(c->gravityid == gravity && c->screenid == screen &&
-          subtle->visible_tags & c->tags &&
-          !(c->flags & (SUB_CLIENT_MODE_FLOAT|SUB_CLIENT_MODE_FULL)))
+      if(g->flags & SUB_GRAVITY_HORZ)
         {
-          if(g->flags & SUB_GRAVITY_HORZ)
-            {
-              c->geom.width  = pos == used ? calc + fix : calc;
-              c->geom.height = geom.height;
-              c->geom.x      = geom.x + pos++ * calc;
-              c->geom.y      = geom.y;
-            }
-          else
-            {
-              c->geom.width  = geom.width;
-              c->geom.height = pos == used ? calc + fix : calc;
-              c->geom.x      = geom.x;
-              c->geom.y      = geom.y + pos++ * calc;
-            }
-
-          ClientResize(c, &(s->geom));
+          c->geom.width  = pos == used ? calc + fix : calc;
+          c->geom.height = geom.height;
+          c->geom.x      = geom.x + pos++ * calc;
+          c->geom.y      = geom.y;
         }
+      else
+        {
+          c->geom.width  = geom.width;
+          c->geom.height = pos == used ? calc + fix : calc;
+          c->geom.x      = geom.x;
+          c->geom.y      = geom.y + pos++ * calc;
+        }
+
+      ClientResize(c, &(s->geom));
     }
 } /* }}} */
 
@@ -269,6 +596,18 @@ ClientZaphod(SubClient *c,
     }
 } /* }}} */
 
+/* ClientLevel {{{ */
+static int
+ClientLevel(SubClient *c)
+{
+  /* Desktop and dock windows are lowered, fullscreen ones raised */
+  if(c->flags & (SUB_CLIENT_TYPE_DESKTOP|SUB_CLIENT_TYPE_DOCK)) return 0;
+  else if(c->flags & SUB_CLIENT_MODE_FULL)                      return 3;
+  else if(c->flags & SUB_CLIENT_MODE_FLOAT)                     return 2;
+
+  return 1;
+} /* }}} */
+
 /* ClientCompare {{{ */
 static int
 ClientCompare(const void *a,
@@ -285,38 +624,213 @@ ClientCompare(const void *a,
   else if(SUB_CLIENT_RESTACK_DOWN == c2->dir) dirret = 1;
   else if(SUB_CLIENT_RESTACK_UP   == c2->dir) dirret = -1;
 
-  /* Complicated comparisons to ensure stacking order. Our desired
-   * order is following: desktop < gravity < float < full
+  /* Compare levels to ensure stacking order. Our desired
+   * order is following: desktop/dock < gravity < float < full
    *
    * This function returns following values:
-   * -1 => c1 is on a lower level
+   * <0 => c1 is on a lower level
    *  0 => c1 and c2 are on the same level
-   *  1 => c1 is on a higher level */
-  if(c1->flags & SUB_CLIENT_TYPE_DESKTOP)
+   * >0 => c1 is on a higher level */
+  ret = ClientLevel(c1) - ClientLevel(c2);
+
+  if(0 == ret) ret = dirret;
+
+  /* Keep previous order on same level, qsort isn't stable */
+  if(0 == ret) ret = c1->idx - c2->idx;
+
+  return ret;
+} /* }}} */
+
+/* ClientMruUnlink {{{ */
+static void
+ClientMruUnlink(SubClient *c)
+{
+  if(c->mruprev) c->mruprev->mrunext = c->mrunext;
+  else if(mruhead == c) mruhead = c->mrunext;
+
+  if(c->mrunext) c->mrunext->mruprev = c->mruprev;
+  else if(mrutail == c) mrutail = c->mruprev;
+
+  c->mruprev = c->mrunext = NULL;
+} /* }}} */
+
+/* ClientMruAppend {{{ */
+static void
+ClientMruAppend(SubClient *c)
+{
+  /* Never focused clients are least recent */
+  c->mruprev = mrutail;
+  c->mrunext = NULL;
+
+  if(mrutail) mrutail->mrunext = c;
+  else mruhead = c;
+
+  mrutail = c;
+} /* }}} */
+
+/* ClientCenterX {{{ */
+static int
+ClientCenterX(const void *a,
+  const void *b)
+{
+  SubClient *c1 = *(SubClient **)a, *c2 = *(SubClient **)b;
+
+  return (c1->geom.x + c1->geom.width / 2) - (c2->geom.x + c2->geom.width / 2);
+} /* }}} */
+
+/* ClientCenterY {{{ */
+static int
+ClientCenterY(const void *a,
+  const void *b)
+{
+  SubClient *c1 = *(SubClient **)a, *c2 = *(SubClient **)b;
+
+  return (c1->geom.y + c1->geom.height / 2) - (c2->geom.y + c2->geom.height / 2);
+} /* }}} */
+
+/* ClientSpatialRebuild {{{ */
+static void
+ClientSpatialRebuild(void)
+{
+  int i;
+
+  spatialx = (SubClient **)subSharedMemoryRealloc(spatialx,
+    (subtle->clients->ndata + 1) * sizeof(SubClient *));
+  spatialy = (SubClient **)subSharedMemoryRealloc(spatialy,
+    (subtle->clients->ndata + 1) * sizeof(SubClient *));
+
+  /* Collect visible clients */
+  for(i = 0, nspatial = 0; i < subtle->clients->ndata; i++)
     {
-      if(c2->flags & SUB_CLIENT_TYPE_DESKTOP) ret = dirret;
-      else ret = 0;
+      SubClient *c = CLIENT(subtle->clients->data[i]);
+
+      if(ALIVE(c) && (subtle->visible_tags & c->tags ||
+          c->flags & SUB_CLIENT_MODE_STICK))
+        spatialx[nspatial++] = c;
     }
-  else if(c1->flags & SUB_CLIENT_MODE_FULL)
+
+  /* Sort by window centers */
+  memcpy(spatialy, spatialx, nspatial * sizeof(SubClient *));
+
+  qsort(spatialx, nspatial, sizeof(SubClient *), ClientCenterX);
+  qsort(spatialy, nspatial, sizeof(SubClient *), ClientCenterY);
+
+  spatialtags  = subtle->visible_tags;
+  spatialdirty = False;
+} /* }}} */
+
+/* ClientMatch {{{ */
+static int
+ClientMatch(int type,
+  XRectangle *origin,
+  XRectangle *test)
+{
+  int cx_origin = 0, cx_test = 0, cy_origin = 0, cy_test = 0, dx = 0, dy = 0;
+
+  /* This check is complicated and consists of three parts:
+   * 1) Calculate window center positions
+   * 2) Check if x/y values decrease in given direction
+   * 3) Check if a corner of one of the rects is close enough to
+   *    a side of the other rect */
+
+  /* Calculate window centers */
+  cx_origin = origin->x + (origin->width / 2);
+  cx_test   = test->x + (test->width / 2);
+
+  cy_origin = origin->y + (origin->height / 2);
+  cy_test   = test->y + (test->height / 2);
+
+  /* Check geometries */
+  if((((SUB_GRAB_DIRECTION_LEFT  == type      && cx_test   <= cx_origin)                  ||
+       (SUB_GRAB_DIRECTION_RIGHT == type      && cx_test   >= cx_origin))                 &&
+       ((cy_test                 >= origin->y && cy_test   <= origin->y + origin->height) ||
+       (cy_origin                >= test->y   && cy_origin <= test->y   + test->height))) ||
+
+     (((SUB_GRAB_DIRECTION_UP    == type      && cy_test   <= cy_origin)                  ||
+       (SUB_GRAB_DIRECTION_DOWN  == type      && cy_test   >= cy_origin))                 &&
+       ((cx_test                 >= origin->x && cx_test   <= origin->x + origin->width)  ||
+       (cx_origin                 >= test->x   && cx_origin <= test->x   + test->width))))
     {
-      if(c2->flags & SUB_CLIENT_MODE_FULL) ret = dirret;
-      else ret = 1;
+      /* Euclidean distance */
+      dx = abs(cx_origin - cx_test);
+      dy = abs(cy_origin - cy_test);
+
+      /* Zero distance means same dimensions - highest distance */
+      if(0 == dx && 0 == dy) dx = dy = 1L << 15;
     }
-  else if(c1->flags & SUB_CLIENT_MODE_FLOAT)
+  else
     {
-      if(c2->flags & SUB_CLIENT_MODE_FULL) ret = -1;
-      else if(c2->flags & SUB_CLIENT_MODE_FLOAT) ret = dirret;
-      else ret = 1;
+      /* No match - highest distance too */
+      dx = 1L << 15;
+      dy = 1L << 15;
     }
-  else
+
+  return dx + dy;
+} /* }}} */
+
+/* ClientScore {{{ */
+static int
+ClientScore(SubClient *c,
+  SubClient *k,
+  int direction)
+{
+  int j, distance = 0;
+
+  /* Substract stack position index to get top window */
+  distance = ClientMatch(direction, &c->geom, &k->geom) - k->idx;
+
+  /* Substract history stack position index */
+  for(j = 1; j < HISTORYSIZE; j++)
     {
-      if(c2->flags & SUB_CLIENT_TYPE_DESKTOP) ret = 1;
-      else if(c2->flags & (SUB_CLIENT_MODE_FLOAT|
-          SUB_CLIENT_MODE_FULL)) ret = -1;
-      else ret = dirret;
+      if(subtle->windows.focus[j] == k->win)
+        {
+          distance -= (HISTORYSIZE - j);
+          break;
+        }
     }
 
-  return ret;
+  return distance;
+} /* }}} */
+
+/* ClientStackSync {{{ */
+static void
+ClientStackSync(void)
+{
+  int i;
+
+  /* Keep client windows from top (=> 0) to bottom as sent to server */
+  if(nstacked != subtle->clients->ndata)
+    {
+      nstacked = subtle->clients->ndata;
+      stacked  = (Window *)subSharedMemoryRealloc(stacked,
+        (nstacked + 1) * sizeof(Window));
+    }
+
+  for(i = 0; i < nstacked; i++)
+    stacked[nstacked - 1 - i] = CLIENT(subtle->clients->data[i])->win;
+} /* }}} */
+
+/* ClientStackOthers {{{ */
+static int
+ClientStackOthers(SubClient *c)
+{
+  int i = subtle->clients->ndata - 1, j = 0;
+
+  /* Check whether all other clients kept their order */
+  while(True)
+    {
+      if(0 <= i && CLIENT(subtle->clients->data[i]) == c) i--;
+      if(j < nstacked && stacked[j] == c->win) j++;
+
+      if(0 > i || j >= nstacked) break;
+
+      if(CLIENT(subtle->clients->data[i])->win != stacked[j]) return False;
+
+      i--;
+      j++;
+    }
+
+  return (0 > i && j >= nstacked);
 } /* }}} */
 
 /* Public */
@@ -336,12 +850,27 @@ subClientNew(Window win)
   XSetWindowAttributes sattrs;
   Window *leader = NULL;
   SubClient *c = NULL;
+  ClientPrefetchWin *p = NULL;
 
   assert(win);
 
+  /* Fetch attributes and properties unless already done */
+  if(!(p = ClientPrefetchFind(win)))
+    {
+      subClientPrefetch(&win, 1);
+
+      if(!(p = ClientPrefetchFind(win))) return NULL;
+    }
+
+  attrs = p->attrs;
+
   /* Check override_redirect */
-  XGetWindowAttributes(subtle->dpy, win, &attrs);
-  if(True == attrs.override_redirect) return NULL;
+  if(True == attrs.override_redirect)
+    {
+      ClientPrefetchDrop(p);
+
+      return NULL;
+    }
 
   /* Create new client */
   c = CLIENT(subSharedMemoryAlloc(1, sizeof(SubClient)));
@@ -349,6 +878,8 @@ subClientNew(Window win)
   c->flags     = (SUB_TYPE_CLIENT|SUB_CLIENT_INPUT);
   c->gravityid = -1; ///< Force update
   c->dir       = -1;
+  c->memberid  = -1;
+  c->state     = -1; ///< Force update
   c->win       = win;
 
   /* Window attributes */
@@ -358,16 +889,21 @@ subClientNew(Window win)
   c->geom.width  = MAX(MINW, attrs.width);
   c->geom.height = MAX(MINH, attrs.height);
 
+  /* Geometry the server already knows */
+  c->sent.x      = attrs.x;
+  c->sent.y      = attrs.y;
+  c->sent.width  = attrs.width;
+  c->sent.height = attrs.height;
+
   /* Init gravities */
   grav = ClientGravity();
   for(i = 0; i < subtle->views->ndata; i++)
     c->gravities[i] = grav;
 
    /* Fetch name, instance, class and role */
-  subSharedPropertyClass(subtle->dpy, c->win, &c->instance, &c->klass);
-  subSharedPropertyName(subtle->dpy, c->win, &c->name, c->klass);
-  c->role = subSharedPropertyGet(subtle->dpy, c->win, XA_STRING,
-    subEwmhGet(SUB_EWMH_WM_WINDOW_ROLE), NULL);
+  ClientClass(c);
+  ClientName(c);
+  ClientRole(c);
 
   /* X properties */
   sattrs.border_pixel = subtle->styles.clients.bg; ///< Inactive
@@ -379,43 +915,215 @@ subClientNew(Window win)
   XSetWindowBorderWidth(subtle->dpy, c->win,
     subtle->styles.clients.border.top);
 
-  /* Update client */
-  subEwmhSetWMState(c->win, WithdrawnState);
-  subClientSetProtocols(c);
-  subClientSetStrut(c);
-  subClientSetType(c, &flags);
-  subClientRetag(c, &flags);
-  subClientSetSizeHints(c, &flags);
-  subClientSetWMHints(c, &flags);
-  subClientSetState(c, &flags);
-  subClientSetTransient(c, &flags);
-  subClientSetMWMHints(c);
-  subClientToggle(c, flags, False);
-  subGrabUnset(c->win);
+  /* Update client */
+  subEwmhSetWMState(c->win, WithdrawnState);
+
+  /* Mapped windows need a map to get the new state */
+  if(IsViewable != attrs.map_state) c->state = WithdrawnState;
+
+  subClientSetProtocols(c);
+  subClientSetStrut(c);
+  subClientSetType(c, &flags);
+
+  /* Restore state after restart or match tags */
+  if(!subStateClient(c, &flags)) subClientRetag(c, &flags);
+
+  subClientSetSizeHints(c, &flags);
+  subClientSetWMHints(c, &flags);
+  subClientSetState(c, &flags);
+  subClientSetTransient(c, &flags);
+  subClientSetMWMHints(c);
+  subClientToggle(c, flags, False);
+  subGrabUnset(c->win);
+
+  /* Set leader window */
+  if((leader = (Window *)ClientProperty(c, XA_WINDOW,
+      subEwmhGet(SUB_EWMH_WM_CLIENT_LEADER), NULL)))
+    {
+      c->leader = *leader;
+
+      free(leader);
+    }
+
+  /* Drop prefetched data */
+  if((p = ClientPrefetchFind(win))) ClientPrefetchDrop(p);
+
+  /* EWMH: Gravity, screen, desktop, extents */
+  subEwmhSetCardinals(c->win, SUB_EWMH_SUBTLE_CLIENT_GRAVITY,
+    (long *)&subtle->gravity, 1);
+  subEwmhSetCardinals(c->win, SUB_EWMH_SUBTLE_CLIENT_SCREEN,
+    (long *)&c->screenid, 1);
+  subEwmhSetCardinals(c->win, SUB_EWMH_NET_WM_DESKTOP, &vid, 1);
+  subEwmhSetCardinals(c->win, SUB_EWMH_NET_FRAME_EXTENTS, extents, 4);
+
+  c->sentgravity = subtle->gravity;
+  c->sentscreen  = c->screenid;
+  c->sentview    = vid;
+
+  ClientMruAppend(c);
+
+  spatialdirty = True;
+
+  subSubtleLogDebugSubtle("New: name=%s, instance=%s, "
+    "class=%s, win=%#lx, input=%d, focus=%d\n",
+    c->name, c->instance, c->klass, win, !!(c->flags & SUB_CLIENT_INPUT),
+    !!(c->flags & SUB_CLIENT_FOCUS));
+
+  return c;
+} /* }}} */
+
+ /** subClientPrefetch {{{
+  * @brief Prefetch attributes and properties of windows for adoption
+  * @param[in]  wins   Window list
+  * @param[in]  nwins  Number of windows
+  **/
+
+void
+subClientPrefetch(Window *wins,
+  int nwins)
+{
+  int i;
+#ifdef HAVE_X11_XLIB_XCB_H
+  int j;
+  xcb_connection_t *conn = XGetXCBConnection(subtle->dpy);
+  xcb_get_window_attributes_cookie_t *acookies = NULL;
+  xcb_get_geometry_cookie_t *gcookies = NULL;
+  xcb_get_property_cookie_t *pcookies = NULL;
+  Atom props[NPREFETCH] =
+  {
+    XA_WM_CLASS, subEwmhGet(SUB_EWMH_NET_WM_NAME), XA_WM_NAME,
+    subEwmhGet(SUB_EWMH_WM_WINDOW_ROLE), subEwmhGet(SUB_EWMH_WM_PROTOCOLS),
+    subEwmhGet(SUB_EWMH_NET_WM_STRUT), subEwmhGet(SUB_EWMH_NET_WM_WINDOW_TYPE),
+    XA_WM_NORMAL_HINTS, XA_WM_HINTS, subEwmhGet(SUB_EWMH_NET_WM_STATE),
+    XA_WM_TRANSIENT_FOR, subEwmhGet(SUB_EWMH_MOTIF_WM_HINTS),
+    subEwmhGet(SUB_EWMH_WM_CLIENT_LEADER)
+  };
+#endif /* HAVE_X11_XLIB_XCB_H */
+
+  assert(wins);
+
+  if(0 >= nwins) return;
+
+  prefetches = (ClientPrefetchWin *)subSharedMemoryRealloc(prefetches,
+    (nprefetches + nwins) * sizeof(ClientPrefetchWin));
+
+#ifdef HAVE_X11_XLIB_XCB_H
+  acookies = (xcb_get_window_attributes_cookie_t *)subSharedMemoryAlloc(
+    nwins, sizeof(xcb_get_window_attributes_cookie_t));
+  gcookies = (xcb_get_geometry_cookie_t *)subSharedMemoryAlloc(
+    nwins, sizeof(xcb_get_geometry_cookie_t));
+  pcookies = (xcb_get_property_cookie_t *)subSharedMemoryAlloc(
+    nwins * NPREFETCH, sizeof(xcb_get_property_cookie_t));
+
+  /* Xlib may still have requests buffered */
+  XFlush(subtle->dpy);
+
+  /* Send all requests at once.. */
+  for(i = 0; i < nwins; i++)
+    {
+      acookies[i] = xcb_get_window_attributes(conn, wins[i]);
+      gcookies[i] = xcb_get_geometry(conn, wins[i]);
+
+      for(j = 0; j < NPREFETCH; j++)
+        pcookies[i * NPREFETCH + j] = xcb_get_property(conn, False, wins[i],
+          props[j], XCB_GET_PROPERTY_TYPE_ANY, 0, 4096);
+    }
+
+  /* ..and collect the replies afterwards */
+  for(i = 0; i < nwins; i++)
+    {
+      ClientPrefetchWin *p = &prefetches[nprefetches];
+      xcb_get_window_attributes_reply_t *areply = NULL;
+      xcb_get_geometry_reply_t *greply = NULL;
+
+      memset(p, 0, sizeof(ClientPrefetchWin));
+
+      areply = xcb_get_window_attributes_reply(conn, acookies[i], NULL);
+      greply = xcb_get_geometry_reply(conn, gcookies[i], NULL);
+
+      /* Skip windows that are already gone, but collect all replies */
+      if(areply && greply)
+        {
+          p->win                     = wins[i];
+          p->attrs.override_redirect = areply->override_redirect;
+          p->attrs.map_state         = areply->map_state;
+          p->attrs.colormap          = areply->colormap;
+          p->attrs.x                 = greply->x;
+          p->attrs.y                 = greply->y;
+          p->attrs.width             = greply->width;
+          p->attrs.height            = greply->height;
+        }
+
+      for(j = 0; j < NPREFETCH; j++)
+        {
+          xcb_get_property_reply_t *reply = NULL;
+
+          p->props[j].prop = props[j];
+
+          if((reply = xcb_get_property_reply(conn,
+              pcookies[i * NPREFETCH + j], NULL)))
+            {
+              if(None != p->win && XCB_NONE != reply->type)
+                ClientPrefetchStore(&p->props[j], reply);
+
+              free(reply);
+            }
+        }
+
+      if(None != p->win) nprefetches++;
 
-  /* Set leader window */
-  if((leader = (Window *)subSharedPropertyGet(subtle->dpy, c->win, XA_WINDOW,
-      subEwmhGet(SUB_EWMH_WM_CLIENT_LEADER), NULL)))
+      if(areply) free(areply);
+      if(greply) free(greply);
+    }
+
+  free(acookies);
+  free(gcookies);
+  free(pcookies);
+#else /* HAVE_X11_XLIB_XCB_H */
+  /* Fetch attributes once, properties are read on demand */
+  for(i = 0; i < nwins; i++)
     {
-      c->leader = *leader;
+      ClientPrefetchWin *p = &prefetches[nprefetches];
 
-      free(leader);
+      memset(p, 0, sizeof(ClientPrefetchWin));
+
+      if(XGetWindowAttributes(subtle->dpy, wins[i], &p->attrs))
+        {
+          p->win = wins[i];
+          nprefetches++;
+        }
     }
+#endif /* HAVE_X11_XLIB_XCB_H */
 
-  /* EWMH: Gravity, screen, desktop, extents */
-  subEwmhSetCardinals(c->win, SUB_EWMH_SUBTLE_CLIENT_GRAVITY,
-    (long *)&subtle->gravity, 1);
-  subEwmhSetCardinals(c->win, SUB_EWMH_SUBTLE_CLIENT_SCREEN,
-    (long *)&c->screenid, 1);
-  subEwmhSetCardinals(c->win, SUB_EWMH_NET_WM_DESKTOP, &vid, 1);
-  subEwmhSetCardinals(c->win, SUB_EWMH_NET_FRAME_EXTENTS, extents, 4);
+  subSubtleLogDebugSubtle("Prefetch: wins=%d, prefetched=%d\n",
+    nwins, nprefetches);
+} /* }}} */
 
-  subSubtleLogDebugSubtle("New: name=%s, instance=%s, "
-    "class=%s, win=%#lx, input=%d, focus=%d\n",
-    c->name, c->instance, c->klass, win, !!(c->flags & SUB_CLIENT_INPUT),
-    !!(c->flags & SUB_CLIENT_FOCUS));
+ /** subClientPrefetchState {{{
+  * @brief Get map state of prefetched window
+  * @param[in]  win  A #Window
+  * @return Returns map state or \p IsUnmapped when not prefetched
+  **/
 
-  return c;
+int
+subClientPrefetchState(Window win)
+{
+  ClientPrefetchWin *p = ClientPrefetchFind(win);
+
+  return p ? p->attrs.map_state : IsUnmapped;
+} /* }}} */
+
+ /** subClientPrefetchFinish {{{
+  * @brief Drop all prefetched data
+  **/
+
+void
+subClientPrefetchFinish(void)
+{
+  while(0 < nprefetches)
+    ClientPrefetchDrop(&prefetches[nprefetches - 1]);
+
+  subSubtleLogDebugSubtle("PrefetchFinish\n");
 } /* }}} */
 
  /** subClientConfigure {{{
@@ -450,6 +1158,54 @@ subClientConfigure(SubClient *c)
     c->win, c->geom.x, c->geom.y, c->geom.width, c->geom.height);
 } /* }}} */
 
+ /** subClientMoveResize {{{
+  * @brief Move and resize client window unless nothing changed
+  * @param[in]  c     A #SubClient
+  * @param[in]  geom  New geometry
+  * @return Returns \p True when a request was sent
+  **/
+
+int
+subClientMoveResize(SubClient *c,
+  XRectangle *geom)
+{
+  assert(c && geom);
+
+  /* Every configure makes the client redraw, so skip no-ops */
+  if(c->sent.x == geom->x && c->sent.y == geom->y &&
+      c->sent.width == geom->width && c->sent.height == geom->height)
+    return False;
+
+  spatialdirty = True;
+
+  subDisplayTrack(c->win);
+  XMoveResizeWindow(subtle->dpy, c->win, geom->x, geom->y,
+    geom->width, geom->height);
+
+  c->sent = *geom;
+
+  return True;
+} /* }}} */
+
+ /** subClientPlace {{{
+  * @brief Place client in geometry minus margin and border
+  * @param[in]  c       A #SubClient
+  * @param[in]  geom    Geometry of the client cell
+  * @param[in]  bounds  Bounds of the screen
+  **/
+
+void
+subClientPlace(SubClient *c,
+  XRectangle *geom,
+  XRectangle *bounds)
+{
+  assert(c && geom);
+
+  c->geom = *geom;
+
+  ClientResize(c, bounds);
+} /* }}} */
+
  /** subClientDimension {{{
   * @brief Redimension clients
   * @param[in]  id  View id
@@ -497,6 +1253,8 @@ subClientFocus(SubClient *c,
 
   if(!VISIBLE(c)) return;
 
+  subDisplayTrack(c->win);
+
   /* Remove urgent after getting focus */
   if(c->flags & SUB_CLIENT_MODE_URGENT)
     {
@@ -507,15 +1265,8 @@ subClientFocus(SubClient *c,
   /* Unset current focus */
   if((focus = CLIENT(subSubtleFind(subtle->windows.focus[0], CLIENTID))))
     {
-      int i;
-
       subGrabUnset(focus->win);
 
-      /* Reorder focus history */
-      for(i = (HISTORYSIZE - 1); 0 < i; i--)
-        subtle->windows.focus[i] = subtle->windows.focus[i - 1];
-      subtle->windows.focus[0] = 0;
-
       /* Exclude desktop type windows */
       if(!(focus->flags & SUB_CLIENT_TYPE_DESKTOP))
         XSetWindowBorder(subtle->dpy, focus->win, subtle->styles.clients.bg);
@@ -531,7 +1282,7 @@ subClientFocus(SubClient *c,
     XSetInputFocus(subtle->dpy, c->win, RevertToPointerRoot, CurrentTime);
 
   /* Update focus */
-  subtle->windows.focus[0] = c->win;
+  subClientRecent(c);
   subGrabSet(c->win, SUB_GRAB_MOUSE);
 
   /* Exclude desktop and dock type windows */
@@ -561,8 +1312,7 @@ subClientFocus(SubClient *c,
   if(warp && !(subtle->flags & SUB_SUBTLE_SKIP_WARP)) subClientWarp(c);
 
   /* Update screen */
-  subScreenUpdate();
-  subScreenRender();
+  subScreenDirty(SUB_SUBTLE_UPDATE);
 } /* }}} */
 
  /** subClientNext {{{
@@ -576,47 +1326,248 @@ SubClient *
 subClientNext(int screenid,
   int jump)
 {
-  int i;
   SubClient *c = NULL;
 
   /* Pass 1: Check focus history of current screen */
-  for(i = 1; i < HISTORYSIZE; i++)
+  if((c = subClientRecentNext(NULL, -1, screenid))) return c;
+
+  /* Pass 2: Check focus history of any visible screen */
+  if(1 < subtle->screens->ndata && jump)
+    return subClientRecentNext(NULL, -1, -1);
+
+  return NULL;
+} /* }}} */
+
+ /** subClientRecent {{{
+  * @brief Move client to front of focus history
+  * @param[in]  c  A #SubClient
+  **/
+
+void
+subClientRecent(SubClient *c)
+{
+  int i;
+  SubClient *k = NULL;
+
+  assert(c);
+
+  /* Move to front */
+  if(mruhead != c)
+    {
+      ClientMruUnlink(c);
+
+      c->mrunext = mruhead;
+
+      if(mruhead) mruhead->mruprev = c;
+      else mrutail = c;
+
+      mruhead = c;
+    }
+
+  /* Keep short history for EWMH and subtlext */
+  for(i = 0, k = mruhead; i < HISTORYSIZE; i++, k = k ? k->mrunext : NULL)
+    subtle->windows.focus[i] = k ? k->win : None;
+} /* }}} */
+
+ /** subClientRecentList {{{
+  * @brief Get whole focus history
+  * @param[out]  nwins  Number of windows
+  * @return Returns windows from most to least recent; free after use
+  **/
+
+Window *
+subClientRecentList(int *nwins)
+{
+  int n = 0;
+  Window *wins = NULL;
+  SubClient *k = NULL;
+
+  assert(nwins);
+
+  wins = (Window *)subSharedMemoryAlloc(subtle->clients->ndata + 1,
+    sizeof(Window));
+
+  for(k = mruhead; k && n < subtle->clients->ndata; k = k->mrunext)
+    wins[n++] = k->win;
+
+  *nwins = n;
+
+  return wins;
+} /* }}} */
+
+ /** subClientRecentNext {{{
+  * @brief Find next visible client in focus history
+  * @param[in]  c         Start after this #SubClient or \p NULL for front
+  * @param[in]  viewid    Limit to view or \p -1
+  * @param[in]  screenid  Limit to screen or \p -1
+  * @return Returns a #SubClient or \p NULL
+  **/
+
+SubClient *
+subClientRecentNext(SubClient *c,
+  int viewid,
+  int screenid)
+{
+  SubView *v = VIEW(subArrayGet(subtle->views, viewid));
+  SubClient *k = NULL;
+
+  /* Walk from most to least recent, skip focus window */
+  for(k = c ? c->mrunext : mruhead; k; k = k->mrunext)
+    {
+      if(k->win == subtle->windows.focus[0] || !ALIVE(k)) continue;
+
+      if((-1 == screenid || k->screenid == screenid) &&
+          (v ? VISIBLETAGS(k, v->tags) : VISIBLE(k)))
+        return k;
+    }
+
+  return NULL;
+} /* }}} */
+
+ /** subClientRecentCycle {{{
+  * @brief Step deeper into focus history on every call like alt-tab
+  * @param[in]  viewid    Limit to view
+  * @param[in]  screenid  Limit to screen or \p -1
+  * @return Returns a #SubClient or \p NULL
+  **/
+
+SubClient *
+subClientRecentCycle(int viewid,
+  int screenid)
+{
+  int i;
+  SubView *v = VIEW(subArrayGet(subtle->views, viewid));
+  SubClient *k = NULL;
+
+  if(!v) return NULL;
+
+  /* Take a snapshot of the history unless focus is still where we left it,
+   * because focusing moves the client to the front */
+  if(0 == ncycle || -1 == cyclepos ||
+      cycle[cyclepos] != subtle->windows.focus[0])
     {
-      if((c = CLIENT(subSubtleFind(subtle->windows.focus[i], CLIENTID))))
+      cycle = (Window *)subSharedMemoryRealloc(cycle,
+        (subtle->clients->ndata + 1) * sizeof(Window));
+      ncycle = 0;
+
+      for(k = mruhead; k; k = k->mrunext)
         {
-          /* Check visibility on current screen */
-          if(c->screenid == screenid && ALIVE(c) && VISIBLE(c) &&
-              c->win != subtle->windows.focus[0])
-            return c;
+          if(ALIVE(k) && (-1 == screenid || k->screenid == screenid) &&
+              VISIBLETAGS(k, v->tags))
+            cycle[ncycle++] = k->win;
         }
+
+      cyclepos = (0 < ncycle && cycle[0] == subtle->windows.focus[0]) ? 0 : -1;
     }
 
-  /* Pass 2: Check client stacking list backwards of current screen */
-  for(i = subtle->clients->ndata - 1; 0 <= i; i--)
+  /* Next client that is still around, wrap at the end */
+  for(i = 1; i <= ncycle; i++)
     {
-      c = CLIENT(subtle->clients->data[i]);
+      int pos = (cyclepos + i + ncycle) % ncycle;
 
-      /* Check visibility on current screen */
-      if(c->screenid == screenid && ALIVE(c) && VISIBLE(c) &&
-          c->win != subtle->windows.focus[0])
-        return c;
+      if((k = CLIENT(subSubtleFind(cycle[pos], CLIENTID))) &&
+          ALIVE(k) && VISIBLETAGS(k, v->tags))
+        {
+          cyclepos = pos;
+
+          return k;
+        }
     }
 
-  /* Pass 3: Check client stacking list backwards of any visible screen */
-  if(1 < subtle->screens->ndata && jump)
+  return NULL;
+} /* }}} */
+
+ /** subClientSelect {{{
+  * @brief Find closest visible client in direction
+  * @param[in]  c          A #SubClient
+  * @param[in]  direction  Select direction
+  * @return Returns a #SubClient or \p NULL
+  **/
+
+SubClient *
+subClientSelect(SubClient *c,
+  int direction)
+{
+  int i, lo = 0, hi = 0, center = 0, step = 0, slack = 0;
+  int match = (1L << 30), distance = 0, horz = 0;
+  SubClient *found = NULL, **list = NULL;
+
+  assert(c);
+
+  if(spatialdirty || spatialtags != subtle->visible_tags)
+    ClientSpatialRebuild();
+
+  horz   = (direction & (SUB_GRAB_DIRECTION_LEFT|SUB_GRAB_DIRECTION_RIGHT));
+  list   = horz ? spatialx : spatialy;
+  center = horz ? c->geom.x + c->geom.width / 2 :
+    c->geom.y + c->geom.height / 2;
+
+  /* Find first client with center beyond ours */
+  lo = 0;
+  hi = nspatial;
+
+  while(lo < hi)
+    {
+      int mid = (lo + hi) / 2;
+      SubClient *k = list[mid];
+
+      if((horz ? k->geom.x + k->geom.width / 2 :
+          k->geom.y + k->geom.height / 2) <= center)
+        lo = mid + 1;
+      else hi = mid;
+    }
+
+  /* Walk away from our center, clients further away than the best match
+   * plus the largest stack and history bonus can't win anymore */
+  if(direction & (SUB_GRAB_DIRECTION_LEFT|SUB_GRAB_DIRECTION_UP))
+    {
+      i    = lo - 1;
+      step = -1;
+    }
+  else
+    {
+      /* Clients sharing our center match both ways */
+      while(0 < lo && (horz ? list[lo - 1]->geom.x + list[lo - 1]->geom.width / 2 :
+          list[lo - 1]->geom.y + list[lo - 1]->geom.height / 2) == center)
+        lo--;
+
+      i    = lo;
+      step = 1;
+    }
+
+  slack = subtle->clients->ndata + HISTORYSIZE;
+
+  for(; 0 <= i && i < nspatial; i += step)
+    {
+      SubClient *k = list[i];
+
+      if(abs((horz ? k->geom.x + k->geom.width / 2 :
+          k->geom.y + k->geom.height / 2) - center) - slack > match)
+        break;
+
+      if(c != k && match > (distance = ClientScore(c, k, direction)))
+        {
+          match = distance;
+          found = k;
+        }
+    }
+
+  /* No neighbour in that direction, fall back to the best of all */
+  if(!found || (1L << 16) - slack <= match)
     {
-      for(i = subtle->clients->ndata - 1; 0 <= i; i--)
+      for(i = 0; i < nspatial; i++)
         {
-          c = CLIENT(subtle->clients->data[i]);
+          SubClient *k = list[i];
 
-          /* Check visibility on current screen */
-          if(ALIVE(c) && VISIBLE(c) &&
-              c->win != subtle->windows.focus[0])
-            return c;
+          if(c != k && match > (distance = ClientScore(c, k, direction)))
+            {
+              match = distance;
+              found = k;
+            }
         }
     }
 
-  return NULL;
+  return found;
 } /* }}} */
 
  /** subClientWarp {{{
@@ -652,8 +1603,10 @@ subClientDrag(SubClient *c,
   XEvent ev;
   Window root = None, win = None;
   unsigned int mask = 0;
+  unsigned long last = 0;
   int loop = True, edge = 0, fx = 0, fy = 0, dx = 0, dy = 0;
   int wx = 0, wy = 0, ww = 0, wh = 0, rx = 0, ry = 0;
+  int opaque = (subtle->flags & SUB_SUBTLE_OPAQUE), pending = False;
   SubScreen *s = NULL;
   XRectangle geom = { 0 };
   Cursor cursor;
@@ -708,10 +1661,10 @@ subClientDrag(SubClient *c,
         break;
     } /* }}} */
 
-  /* Grab pointer server */
+  /* Grab pointer and server, opaque mode leaves other clients running */
   XGrabPointer(subtle->dpy, c->win, True, GRABMASK, GrabModeAsync,
     GrabModeAsync, None, cursor, CurrentTime);
-  XGrabServer(subtle->dpy);
+  if(!opaque) XGrabServer(subtle->dpy);
 
   switch(direction)
     {
@@ -754,12 +1707,29 @@ subClientDrag(SubClient *c,
         ClientBounds(c, &(s->geom), &c->geom, False, False);
         break; /* }}}*/
       default: /* {{{ */
-        ClientMask(&geom);
+        if(!opaque) ClientMask(&geom);
 
         /* Start event loop */
         while(loop)
           {
-            XMaskEvent(subtle->dpy, DRAGMASK, &ev);
+            /* Opaque: Apply held back geometry once the pointer rests */
+            if(pending)
+              {
+                if(!XCheckMaskEvent(subtle->dpy, DRAGMASK, &ev))
+                  {
+                    if(!ClientDragWait(last))
+                      {
+                        ClientDragApply(c, &geom);
+
+                        last    = subStatsTime();
+                        pending = False;
+                      }
+
+                    continue;
+                  }
+              }
+            else XMaskEvent(subtle->dpy, DRAGMASK, &ev);
+
             switch(ev.type)
               {
                 case EnterNotify:   win = ev.xcrossing.window; break; ///< Find destination window
@@ -769,12 +1739,16 @@ subClientDrag(SubClient *c,
                 case MotionNotify: /* {{{ */
                   if(mode & (SUB_DRAG_MOVE|SUB_DRAG_RESIZE))
                     {
+                      /* Compress motion, just the latest position matters */
+                      while(XCheckMaskEvent(subtle->dpy,
+                        PointerMotionMask, &ev));
+
                       /* Check values */
                       if(!XYINRECT(ev.xmotion.x_root - dx,
                           ev.xmotion.y_root - dy, s->geom))
                         continue;
 
-                      ClientMask(&geom);
+                      if(!opaque) ClientMask(&geom);
 
                       /* Calculate selection rect */
                       switch(mode)
@@ -814,30 +1788,35 @@ subClientDrag(SubClient *c,
                             break; /* }}} */
                         }
 
-                      ClientMask(&geom);
+                      /* Update window at most once per interval */
+                      if(opaque)
+                        {
+                          if(subStatsTime() >= last + DRAGRATE * 1000)
+                            {
+                              ClientDragApply(c, &geom);
+
+                              last    = subStatsTime();
+                              pending = False;
+                            }
+                          else pending = True;
+                        }
+                      else ClientMask(&geom);
                     }
                   break; /* }}} */
               }
           }
 
-        ClientMask(&geom); ///< Erase mask
+        if(!opaque) ClientMask(&geom); ///< Erase mask
 
-        /* Subtract border width */
-        if(!(c->flags & SUB_CLIENT_MODE_BORDERLESS))
-          {
-            geom.x -= subtle->styles.clients.border.top;
-            geom.y -= subtle->styles.clients.border.top;
-          } /* }}} */
-
-        c->geom = geom;
+        ClientDragApply(c, &geom);
+        break; /* }}} */
     }
 
-  XMoveResizeWindow(subtle->dpy, c->win, c->geom.x, c->geom.y,
-    c->geom.width, c->geom.height);
+  subClientMoveResize(c, &c->geom);
 
   /* Remove grabs */
   XUngrabPointer(subtle->dpy, CurrentTime);
-  XUngrabServer(subtle->dpy);
+  if(!opaque) XUngrabServer(subtle->dpy);
 } /* }}} */
 
  /** subClientTag {{{
@@ -902,6 +1881,8 @@ subClientTag(SubClient *c,
       /* Call proc if any */
       if(t->flags & SUB_TAG_PROC)
         subRubyCall(SUB_CALL_HOOKS, t->proc, (void *)c);
+
+      ClientMembersSync(c, False);
     }
 } /* }}} */
 
@@ -1005,6 +1986,24 @@ subClientResize(SubClient *c,
     }
 } /* }}} */
 
+ /** subClientSyncMembers {{{
+  * @brief Sync tile members after visible tags changed
+  **/
+
+void
+subClientSyncMembers(void)
+{
+  int i;
+
+  /* Rebuild once when screens or gravities changed */
+  if(!ClientMembersValid()) ClientMembersRebuild();
+  else
+    {
+      for(i = 0; i < subtle->clients->ndata; i++)
+        ClientMembersSync(CLIENT(subtle->clients->data[i]), False);
+    }
+} /* }}} */
+
  /** subClientRestack {{{
   * @brief Restack client
   * @param[in]  c    A #SubClient
@@ -1015,11 +2014,51 @@ void
 subClientRestack(SubClient *c,
   int dir)
 {
+  int idx = 0;
+  XWindowChanges wc;
+
   c->dir = dir;
   subArraySort(subtle->clients, ClientCompare);
   c->dir = -1;
 
-  subClientPublish(True);
+  ClientMembersSync(c, True); ///< Only c moved in client list
+
+  /* Startup scan publishes once afterwards */
+  if(subtle->flags & SUB_SUBTLE_SCAN) return;
+
+  /* Move just this window next to its new neighbour when nothing else
+   * changed, otherwise restack all */
+  if(ClientStackOthers(c))
+    {
+      idx = subArrayIndex(subtle->clients, (void *)c);
+
+      if(idx + 1 < subtle->clients->ndata)
+        {
+          wc.sibling    = CLIENT(subtle->clients->data[idx + 1])->win;
+          wc.stack_mode = Below;
+        }
+      else if(0 < idx)
+        {
+          wc.sibling    = CLIENT(subtle->clients->data[idx - 1])->win;
+          wc.stack_mode = Above;
+        }
+      else wc.sibling = None;
+
+      if(None != wc.sibling)
+        XConfigureWindow(subtle->dpy, c->win, CWSibling|CWStackMode, &wc);
+
+      ClientStackSync();
+    }
+  else
+    {
+      ClientStackSync();
+      XRestackWindows(subtle->dpy, stacked, nstacked);
+    }
+
+  /* EWMH: Client list stacking, once per event batch */
+  subtle->flags |= SUB_SUBTLE_STACKING;
+
+  if(!(subtle->flags & SUB_SUBTLE_RUN)) subClientPublishStacking();
 
   subSubtleLogDebugSubtle("Restack: instance=%s, win=%#lx, dir=%s\n",
     c->instance, c->win, SUB_CLIENT_RESTACK_DOWN == dir ? "down" : "up");
@@ -1042,17 +2081,21 @@ subClientArrange(SubClient *c,
   DEAD(c);
   assert(c && s);
 
+  subDisplayTrack(c->win);
+
+  spatialdirty = True; ///< Visibility may have changed
+
   /* Check flags */
   if(c->flags & SUB_CLIENT_MODE_FULL)
     {
       /* Use all screens when in zaphod mode */
       if(c->flags & SUB_CLIENT_MODE_ZAPHOD)
         {
-          XMoveResizeWindow(subtle->dpy, c->win, 0, 0,
-            subtle->width, subtle->height);
+          XRectangle full = { 0, 0, subtle->width, subtle->height };
+
+          subClientMoveResize(c, &full);
         }
-      else XMoveResizeWindow(subtle->dpy, c->win, s->base.x, s->base.y,
-        s->base.width, s->base.height);
+      else subClientMoveResize(c, &(s->base));
 
       XRaiseWindow(subtle->dpy, c->win);
     }
@@ -1071,13 +2114,13 @@ subClientArrange(SubClient *c,
               c->geom.width  = c->geom.width;
               c->geom.height = c->geom.height;
               c->screenid    = screenid;
+
+              ClientMembersSync(c, False);
             }
 
           /* Finally resize window */
           subClientResize(c, &(s->geom), True);
-
-          XMoveResizeWindow(subtle->dpy, c->win, c->geom.x, c->geom.y,
-            c->geom.width, c->geom.height);
+          subClientMoveResize(c, &c->geom);
         }
     }
   else if(c->flags & SUB_CLIENT_TYPE_DESKTOP)
@@ -1085,15 +2128,13 @@ subClientArrange(SubClient *c,
       c->geom = s->geom;
 
       /* Just use screen size for desktop windows */
-      XMoveResizeWindow(subtle->dpy, c->win, c->geom.x, c->geom.y,
-        c->geom.width, c->geom.height);
+      subClientMoveResize(c, &c->geom);
       XLowerWindow(subtle->dpy, c->win);
     }
   else if(c->flags & SUB_CLIENT_TYPE_DOCK)
     {
       /* Just use screen size for desktop windows */
-      XMoveResizeWindow(subtle->dpy, c->win, c->geom.x, c->geom.y,
-        c->geom.width, c->geom.height);
+      subClientMoveResize(c, &c->geom);
       XLowerWindow(subtle->dpy, c->win);
     }
   else
@@ -1110,6 +2151,8 @@ subClientArrange(SubClient *c,
           if(-1 != gravityid)
             c->gravityid = c->gravities[s->viewid] = gravityid;
 
+          ClientMembersSync(c, False);
+
           g     = GRAVITY(subArrayGet(subtle->gravities, gravityid));
           old_g = GRAVITY(subArrayGet(subtle->gravities, old_gravity));
 
@@ -1117,13 +2160,15 @@ subClientArrange(SubClient *c,
           if(-1 != old_screen && (subtle->flags & SUB_SUBTLE_TILING ||
               (old_g && old_g->flags & (SUB_GRAVITY_HORZ|SUB_GRAVITY_VERT))))
             ClientTile(old_gravity, old_screen);
+          else if(-1 != old_screen && old_screen != c->screenid)
+            subLayoutDirty(old_screen);
 
           if(subtle->flags & SUB_SUBTLE_TILING ||
               (g && g->flags & (SUB_GRAVITY_HORZ|SUB_GRAVITY_VERT)))
             {
               ClientTile(gravityid, -1 == screenid ? 0 : screenid);
             }
-          else
+          else if(!subLayoutDirty(c->screenid))
             {
               /* Set size for bounds*/
               if(c->flags & SUB_CLIENT_MODE_ZAPHOD) ClientZaphod(c, &bounds);
@@ -1132,16 +2177,20 @@ subClientArrange(SubClient *c,
             }
 
           /* EWMH: Gravity */
-          subEwmhSetCardinals(c->win, SUB_EWMH_SUBTLE_CLIENT_GRAVITY,
-            (long *)&c->gravityid, 1);
-
-          XSync(subtle->dpy, False); ///< Sync before going on
+          if(c->sentgravity != c->gravityid)
+            {
+              subEwmhSetCardinals(c->win, SUB_EWMH_SUBTLE_CLIENT_GRAVITY,
+                (long *)&c->gravityid, 1);
+              c->sentgravity = c->gravityid;
+            }
 
           /* Hook: Gravity */
           subHookCall((SUB_HOOK_TYPE_CLIENT|SUB_HOOK_ACTION_GRAVITY),
             (void *)c);
         }
     }
+
+  c->flags &= ~SUB_CLIENT_ARRANGE; ///< Handled
 } /* }}} */
 
  /** subClientToggle {{{
@@ -1306,11 +2355,17 @@ subClientToggle(SubClient *c,
   c->flags = ((c->flags & ~MODES_ALL) |
     ((c->flags & MODES_ALL) ^ (flags & MODES_ALL)));
 
+  ClientMembersSync(c, False);
+
   /* Sort for keeping stacking order */
   if(c->flags & (SUB_CLIENT_MODE_FLOAT|SUB_CLIENT_MODE_FULL|
       SUB_CLIENT_TYPE_DESKTOP|SUB_CLIENT_TYPE_DOCK))
     subClientRestack(c, SUB_CLIENT_RESTACK_UP);
 
+  /* Leaving or joining the tiled clients changes the layout */
+  if(flags & (SUB_CLIENT_MODE_FLOAT|SUB_CLIENT_MODE_FULL) && VISIBLE(c))
+    subLayoutDirty(c->screenid);
+
   /* EWMH: State and flags */
   if(c->flags & SUB_CLIENT_MODE_FULL)
     states[nstates++] = subEwmhGet(SUB_EWMH_NET_WM_STATE_FULLSCREEN);
@@ -1328,8 +2383,6 @@ subClientToggle(SubClient *c,
 
   subEwmhSetCardinals(c->win, SUB_EWMH_SUBTLE_CLIENT_FLAGS, (long *)&flags, 1);
 
-  XSync(subtle->dpy, False); ///< Sync all changes
-
   /* Hook: Mode */
   subHookCall((SUB_HOOK_TYPE_CLIENT|SUB_HOOK_ACTION_MODE), (void *)c);
 
@@ -1351,7 +2404,7 @@ subClientSetStrut(SubClient *c)
   assert(c);
 
   /* Get strut property */
-  if((strut = (long *)subSharedPropertyGet(subtle->dpy, c->win, XA_CARDINAL,
+  if((strut = (long *)ClientProperty(c, XA_CARDINAL,
       subEwmhGet(SUB_EWMH_NET_WM_STRUT), &size)))
     {
       if(4 == size) ///< Only complete struts
@@ -1382,13 +2435,15 @@ subClientSetStrut(SubClient *c)
 void
 subClientSetProtocols(SubClient *c)
 {
-  int i, n = 0;
+  int i;
+  unsigned long n = 0;
   Atom *protos = NULL;
 
   assert(c);
 
   /* Window manager protocols */
-  if(XGetWMProtocols(subtle->dpy, c->win, &protos, &n))
+  if((protos = (Atom *)ClientProperty(c, XA_ATOM,
+      subEwmhGet(SUB_EWMH_WM_PROTOCOLS), &n)))
     {
       for(i = 0; i < n; i++)
         {
@@ -1414,7 +2469,8 @@ void
 subClientSetSizeHints(SubClient *c,
   int *flags)
 {
-  long supplied = 0;
+  unsigned long n = 0;
+  long *prop = NULL;
   XSizeHints *hints = NULL;
   SubScreen *s = NULL;
 
@@ -1443,8 +2499,34 @@ subClientSetSizeHints(SubClient *c,
   c->baseh = 0; /* }}} */
 
   /* Size hints - no idea why it's called normal hints */
-  if(XGetWMNormalHints(subtle->dpy, c->win, hints, &supplied))
+  if((prop = (long *)ClientProperty(c, XA_WM_SIZE_HINTS,
+      XA_WM_NORMAL_HINTS, &n)) && 15 <= n) ///< Pre-ICCCM has 15 items
     {
+      /* Unpack like XGetWMNormalHints */
+      hints->flags        = prop[0];
+      hints->x            = prop[1];
+      hints->y            = prop[2];
+      hints->width        = prop[3];
+      hints->height       = prop[4];
+      hints->min_width    = prop[5];
+      hints->min_height   = prop[6];
+      hints->max_width    = prop[7];
+      hints->max_height   = prop[8];
+      hints->width_inc    = prop[9];
+      hints->height_inc   = prop[10];
+      hints->min_aspect.x = prop[11];
+      hints->min_aspect.y = prop[12];
+      hints->max_aspect.x = prop[13];
+      hints->max_aspect.y = prop[14];
+
+      if(18 <= n)
+        {
+          hints->base_width  = prop[15];
+          hints->base_height = prop[16];
+          hints->win_gravity = prop[17];
+        }
+      else hints->flags &= ~(PBaseSize|PWinGravity);
+
       /* Program min size */
       if(hints->flags & PMinSize)
         {
@@ -1526,6 +2608,7 @@ subClientSetSizeHints(SubClient *c,
         }
     }
 
+  if(prop) free(prop);
   XFree(hints);
 
   subSubtleLogDebug("SetSizeHints: x=%d, y=%d, width=%d, height=%d, "
@@ -1545,13 +2628,27 @@ void
 subClientSetWMHints(SubClient *c,
   int *flags)
 {
-  XWMHints *hints = NULL;
+  unsigned long n = 0;
+  long *prop = NULL;
+  XWMHints wmhints, *hints = &wmhints;
 
   assert(c && flags);
 
   /* Window manager hints (ICCCM 4.1.7) */
-  if((hints = XGetWMHints(subtle->dpy, c->win)))
+  if((prop = (long *)ClientProperty(c, XA_WM_HINTS, XA_WM_HINTS, &n)))
     {
+      /* Unpack like XGetWMHints, pre-ICCCM has no window group */
+      memset(hints, 0, sizeof(XWMHints));
+
+      if(8 <= n)
+        {
+          hints->flags        = prop[0];
+          hints->input        = !!prop[1];
+          hints->window_group = 9 <= n ? prop[8] : None;
+
+          if(9 > n) hints->flags &= ~WindowGroupHint;
+        }
+
       /* Handle urgency hint:
        * Set urgency if window hasn't focus and and
        * remove it after getting focus */
@@ -1578,7 +2675,7 @@ subClientSetWMHints(SubClient *c,
       if(hints->flags & InputHint && !hints->input)
         c->flags &= ~SUB_CLIENT_INPUT;
 
-      XFree(hints);
+      free(prop);
     }
 
   subSubtleLogDebugSubtle("SetWMHints\n");
@@ -1598,7 +2695,7 @@ subClientSetMWMHints(SubClient *c)
   assert(c);
 
   /* Window manager hints */
-  if((hints = (ClientMWMHints *)subSharedPropertyGet(subtle->dpy, c->win,
+  if((hints = (ClientMWMHints *)ClientProperty(c,
       subEwmhGet(SUB_EWMH_MOTIF_WM_HINTS),
       subEwmhGet(SUB_EWMH_MOTIF_WM_HINTS), &size)))
     {
@@ -1633,7 +2730,7 @@ subClientSetState(SubClient *c,
   assert(c);
 
   /* Window state */
-  if((states = (Atom *)subSharedPropertyGet(subtle->dpy, c->win, XA_ATOM,
+  if((states = (Atom *)ClientProperty(c, XA_ATOM,
       subEwmhGet(SUB_EWMH_NET_WM_STATE), &nstates)))
     {
       for(i = 0; i < nstates; i++)
@@ -1655,12 +2752,13 @@ void
 subClientSetTransient(SubClient *c,
   int *flags)
 {
-  Window trans = None;
+  Window *trans = NULL;
 
   assert(c && flags);
 
   /* Check for transient windows */
-  if(XGetTransientForHint(subtle->dpy, c->win, &trans))
+  if((trans = (Window *)ClientProperty(c, XA_WINDOW,
+      XA_WM_TRANSIENT_FOR, NULL)))
     {
       SubClient *k = NULL;
 
@@ -1669,12 +2767,14 @@ subClientSetTransient(SubClient *c,
         SUB_CLIENT_MODE_FLOAT|SUB_CLIENT_MODE_URGENT : SUB_CLIENT_MODE_FLOAT;
 
       /* Find parent window */
-      if((k = CLIENT(subSubtleFind(trans, CLIENTID))))
+      if((k = CLIENT(subSubtleFind(*trans, CLIENTID))))
         {
           *flags      |= (k->flags & MODES_ALL);
           c->tags     |= k->tags;
           c->screenid |= k->screenid;
         }
+
+      free(trans);
      }
 
   subSubtleLogDebugSubtle("SetTransient\n");
@@ -1697,7 +2797,7 @@ subClientSetType(SubClient *c,
   assert(c);
 
   /* Get window type */
-  if((types = (Atom *)subSharedPropertyGet(subtle->dpy, c->win, XA_ATOM,
+  if((types = (Atom *)ClientProperty(c, XA_ATOM,
       subEwmhGet(SUB_EWMH_NET_WM_WINDOW_TYPE), &size)))
     {
       int id = 0;
@@ -1767,8 +2867,7 @@ subClientClose(SubClient *c)
       subClientPublish(False);
 
       subScreenConfigure();
-      subScreenUpdate();
-      subScreenRender();
+      subScreenDirty(SUB_SUBTLE_UPDATE);
 
       /* Update focus if necessary */
       if(-1 != sid)
@@ -1792,6 +2891,14 @@ subClientKill(SubClient *c)
 {
   assert(c);
 
+  ClientMruUnlink(c);
+
+  spatialdirty = True; ///< Drop from index
+
+  /* Remove from tile members, the rest stays in order */
+  if(0 <= c->memberid && c->memberid < nmembers)
+    subArrayRemove(members[c->memberid], (void *)c);
+
   /* Hook: Kill */
   subHookCall((SUB_HOOK_TYPE_CLIENT|SUB_HOOK_ACTION_KILL),
     (void *)c);
@@ -1808,8 +2915,9 @@ subClientKill(SubClient *c)
   if(c->flags & SUB_CLIENT_MODE_URGENT)
     subtle->urgent_tags &= ~c->tags;
 
-  /* Tile remaining clients if necessary */
-  if(VISIBLE(c))
+  /* Tile remaining clients if necessary, but not during shutdown
+   * when the client list is being cleared */
+  if(VISIBLE(c) && subtle->flags & SUB_SUBTLE_RUN)
     {
       SubGravity *g = GRAVITY(subArrayGet(subtle->gravities, c->gravityid));
 
@@ -1820,9 +2928,9 @@ subClientKill(SubClient *c)
 
   if(c->gravities) free(c->gravities);
   if(c->name)      free(c->name);
-  if(c->instance)  free(c->instance);
-  if(c->klass)     free(c->klass);
-  if(c->role)      free(c->role);
+  subStringRelease(c->instance);
+  subStringRelease(c->klass);
+  subStringRelease(c->role);
   free(c);
 
   subSubtleLogDebugSubtle("Kill\n");
@@ -1838,29 +2946,39 @@ subClientKill(SubClient *c)
 void
 subClientPublish(int restack)
 {
-  int i;
-  Window *wins = (Window *)subSharedMemoryAlloc(subtle->clients->ndata,
-    sizeof(Window));
-
-  /* Sort clients from top (=> 0) to bottom */
-  for(i = 0; i < subtle->clients->ndata; i++)
-    wins[subtle->clients->ndata - 1 - i] = CLIENT(subtle->clients->data[i])->win;
+  /* Removed windows keep the order of the others on the server */
+  ClientStackSync();
 
   /* EWMH: Client list and client list stacking (same for us) */
-  subEwmhSetWindows(ROOT, SUB_EWMH_NET_CLIENT_LIST, wins,
-    subtle->clients->ndata);
-  subEwmhSetWindows(ROOT, SUB_EWMH_NET_CLIENT_LIST_STACKING, wins,
-    subtle->clients->ndata);
-
-  /* Restack windows? We assembled the array anyway. */
-  if(restack) XRestackWindows(subtle->dpy, wins, subtle->clients->ndata);
+  subEwmhSetWindows(ROOT, SUB_EWMH_NET_CLIENT_LIST, stacked, nstacked);
+  subEwmhSetWindows(ROOT, SUB_EWMH_NET_CLIENT_LIST_STACKING,
+    stacked, nstacked);
 
-  XSync(subtle->dpy, False); ///< Sync all changes
+  subtle->flags &= ~SUB_SUBTLE_STACKING;
 
-  free(wins);
+  /* Restack windows? We assembled the array anyway. */
+  if(restack) XRestackWindows(subtle->dpy, stacked, nstacked);
 
   subSubtleLogDebugSubtle("Publish: clients=%d, restack=%d\n",
     subtle->clients->ndata, restack);
 } /* }}} */
 
+ /** subClientPublishStacking {{{
+  * @brief Publish client stacking list when restacked
+  **/
+
+void
+subClientPublishStacking(void)
+{
+  if(subtle->flags & SUB_SUBTLE_STACKING)
+    {
+      subEwmhSetWindows(ROOT, SUB_EWMH_NET_CLIENT_LIST_STACKING,
+        stacked, nstacked);
+
+      subtle->flags &= ~SUB_SUBTLE_STACKING;
+
+      subSubtleLogDebugSubtle("PublishStacking: clients=%d\n", nstacked);
+    }
+} /* }}} */
+
 // vim:ts=2:bs=2:sw=2:et:fdm=marker
@@ -15,6 +15,20 @@
 #include <locale.h>
 #include "subtle.h"
 
+#define NTRACKS 64                               ///< Size of the track ring
+
+/* Typedef {{{ */
+typedef struct subdisplaytrack_t
+{
+  unsigned long serial;                          ///< Track first request serial
+  Window        win;                             ///< Track window
+} SubDisplayTrack;
+/* }}} */
+
+/* Globals */
+SubDisplayTrack tracks[NTRACKS];
+unsigned long ntracks = 0;
+
 /* DisplayClaim {{{ */
 int
 DisplayClaim(void)
@@ -97,17 +111,40 @@ static int
 DisplayXError(Display *disp,
   XErrorEvent *ev)
 {
+  SubClient *c = NULL;
+
+  /* Mark client of the failed resource as dead */
+  if((BadWindow == ev->error_code || BadDrawable == ev->error_code) &&
+      (c = CLIENT(subSubtleFind(ev->resourceid, CLIENTID))))
+    c->flags |= SUB_CLIENT_DEAD;
+
 #ifdef DEBUG
   if(subtle->loglevel & SUB_LOG_XERROR)
     {
       if(42 != ev->request_code) /* X_SetInputFocus */
         {
+          int i;
           char error[255] = { 0 };
+          Window track = None;
+
+          /* Errors arrive asynchronously: Find the window that was
+           * tracked when the failed request was sent */
+          for(i = 1; i <= NTRACKS && i <= ntracks; i++)
+            {
+              SubDisplayTrack *t = &tracks[(ntracks - i) % NTRACKS];
+
+              if(t->serial <= ev->serial)
+                {
+                  track = t->win;
+
+                  break;
+                }
+            }
 
           XGetErrorText(disp, ev->error_code, error, sizeof(error));
           subSubtleLog(SUB_LOG_XERROR, __FILE__, __LINE__,
-            "%s: win=%#lx, request=%d\n",
-            error, ev->resourceid, ev->request_code);
+            "%s: win=%#lx, request=%d, track=%#lx\n",
+            error, ev->resourceid, ev->request_code, track);
         }
     }
 #endif /* DEBUG */
@@ -117,6 +154,22 @@ DisplayXError(Display *disp,
 
 /* Public */
 
+ /** subDisplayTrack {{{
+  * @brief Track serial of following requests for window
+  * @param[in]  win  A #Window
+  **/
+
+void
+subDisplayTrack(Window win)
+{
+  SubDisplayTrack *t = &tracks[ntracks % NTRACKS];
+
+  t->serial = NextRequest(subtle->dpy);
+  t->win    = win;
+
+  ntracks++;
+} /* }}} */
+
  /** subDisplayInit {{{
   * @brief Open connection to X server and create display
   * @param[in]  display  The display name as string
@@ -283,13 +336,17 @@ subDisplayScan(void)
   /* Scan for client windows */
   XQueryTree(subtle->dpy, ROOT, &wroot, &parent, &wins, &nwins);
 
+  /* Fetch everything in one batch, adopt in memory and leave
+   * configure, map and restack to the first screen configure */
+  subtle->flags |= SUB_SUBTLE_SCAN;
+
+  subClientPrefetch(wins, nwins);
+
   for(i = 0; i < nwins; i++)
     {
       SubClient *c = NULL;
-      XWindowAttributes attrs;
 
-      XGetWindowAttributes(subtle->dpy, wins[i], &attrs);
-      switch(attrs.map_state)
+      switch(subClientPrefetchState(wins[i]))
         {
           case IsViewable:
             if((c = subClientNew(wins[i])))
@@ -298,9 +355,13 @@ subDisplayScan(void)
         }
     }
 
-  XFree(wins);
+  subClientPrefetchFinish();
+
+  subtle->flags &= ~SUB_SUBTLE_SCAN;
 
-  subClientPublish(False);
+  if(wins) XFree(wins);
+
+  subClientPublish(True);
 
   subSubtleLogDebugSubtle("Scan\n");
 } /* }}} */
@@ -348,8 +409,6 @@ subDisplayPublish(void)
 
   free(colors);
 
-  XSync(subtle->dpy, False); ///< Sync all changes
-
   subSubtleLogDebugSubtle("Publish: colors=%d\n", NCOLORS);
 } /* }}} */
 
@@ -11,22 +11,61 @@
   **/
 
 #include <unistd.h>
+#include <limits.h>
 #include <X11/Xatom.h>
 #include <sys/poll.h>
 #include "subtle.h"
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#define NEVENTS 32
+#endif /* HAVE_SYS_EPOLL_H */
+
 #ifdef HAVE_SYS_INOTIFY_H
-#define BUFLEN (sizeof(struct inotify_event))
+#define BUFLEN (16 * (sizeof(struct inotify_event) + NAME_MAX + 1))
 #endif /* HAVE_SYS_INOTIFY_H */
 
 #ifdef HAVE_X11_EXTENSIONS_XRANDR_H
 #include <X11/extensions/Xrandr.h>
 #endif /* HAVE_X11_EXTENSIONS_XRANDR_H */
 
+#define BATCHSIZE 256                               ///< Max X events per batch
+#define MARKSIZE  512                               ///< Property marks per batch
+
+/* Typedef {{{ */
+typedef struct subqueue_t
+{
+  int                 head, nevents;                ///< Queue head and size
+  time_t              stamps[QUEUESIZE];            ///< Queue push times
+  XClientMessageEvent events[QUEUESIZE];            ///< Queue events
+} SubQueue;
+
+typedef struct submark_t
+{
+  Window              win;                          ///< Mark window
+  Atom                atom;                         ///< Mark property
+  int                 count;                        ///< Mark pending changes
+} SubMark;
+
+typedef struct subahead_t
+{
+  int                 blocked, skipped;             ///< Ahead blocked and overtaken events
+} SubAhead;
+/* }}} */
+
 /* Globals */
 struct pollfd *watches = NULL;
-XClientMessageEvent *queue = NULL;
-int nwatches = 0, nqueue = 0;
+void **watchdata = NULL;
+SubQueue queues[3];
+SubPanel **timers = NULL;
+SubMark marks[MARKSIZE];
+int nwatches = 0, ntimers = 0, nmarks = 0, nscan = 0;
+unsigned long ndropped = 0;
+
+#ifdef HAVE_SYS_EPOLL_H
+struct epoll_event events[NEVENTS];
+int epfd = -2, nready = 0;
+#endif /* HAVE_SYS_EPOLL_H */
 
 /* EventUntag {{{ */
 static void
@@ -78,18 +117,165 @@ EventFindSublet(int id)
   return NULL;
 } /* }}} */
 
+/* EventTimerSwap {{{ */
+static void
+EventTimerSwap(int i,
+  int j)
+{
+  SubPanel *p = timers[i];
+
+  timers[i] = timers[j];
+  timers[j] = p;
+
+  timers[i]->sublet->timer = i;
+  timers[j]->sublet->timer = j;
+} /* }}} */
+
+/* EventTimerUp {{{ */
+static int
+EventTimerUp(int i)
+{
+  int parent;
+
+  /* Move timer towards root while it is due earlier */
+  while(0 < i && timers[i]->sublet->time <
+      timers[(parent = (i - 1) / 2)]->sublet->time)
+    {
+      EventTimerSwap(i, parent);
+      i = parent;
+    }
+
+  return i;
+} /* }}} */
+
+/* EventTimerDown {{{ */
+static void
+EventTimerDown(int i)
+{
+  int child;
+
+  /* Move timer towards leaves while a child is due earlier */
+  while((child = 2 * i + 1) < ntimers)
+    {
+      if(child + 1 < ntimers && timers[child + 1]->sublet->time <
+          timers[child]->sublet->time)
+        child++;
+
+      if(timers[i]->sublet->time <= timers[child]->sublet->time) break;
+
+      EventTimerSwap(i, child);
+      i = child;
+    }
+} /* }}} */
+
+/* EventTimerPhase {{{ */
+static time_t
+EventTimerPhase(SubSublet *s)
+{
+  unsigned long hash = 5381;
+  char *c = NULL;
+
+  /* Derive a stable phase from the sublet name */
+  if(subtle->flags & SUB_SUBTLE_SPREAD && s->name)
+    {
+      for(c = s->name; *c; c++)
+        hash = ((hash << 5) + hash) + *c;
+
+      return hash % s->interval;
+    }
+
+  return 0;
+} /* }}} */
+
+/* EventQueueFind {{{ */
+static SubQueue *
+EventQueueFind(long type)
+{
+  switch(type)
+    {
+      case SUB_TYPE_CLIENT: return &queues[0];
+      case SUB_TYPE_VIEW:   return &queues[1];
+      case SUB_TYPE_TAG:    return &queues[2];
+    }
+
+  return NULL;
+} /* }}} */
+
+/* EventQueueExpire {{{ */
+static void
+EventQueueExpire(SubQueue *q,
+  time_t now)
+{
+  /* Zero expiry keeps entries until the ring is full */
+  if(0 == subtle->expiry) return;
+
+  /* Entries are ordered by age, so just drop from head */
+  while(0 < q->nevents && q->stamps[q->head] + subtle->expiry <= now)
+    {
+      subSubtleLogDebugEvents("Queue expire: id=%ld, data=%ld, type=%ld, dropped=%lu\n",
+        q->events[q->head].data.l[0], q->events[q->head].data.l[1],
+        q->events[q->head].data.l[4], ndropped + 1);
+
+      q->head = (q->head + 1) % QUEUESIZE;
+      q->nevents--;
+      ndropped++;
+    }
+} /* }}} */
+
+/* EventQueueDeadline {{{ */
+static time_t
+EventQueueDeadline(void)
+{
+  int i;
+  time_t deadline = -1;
+
+  if(0 == subtle->expiry) return -1;
+
+  /* Find oldest entry of all queues */
+  for(i = 0; i < LENGTH(queues); i++)
+    {
+      SubQueue *q = &queues[i];
+
+      if(0 < q->nevents && (0 > deadline ||
+          q->stamps[q->head] + subtle->expiry < deadline))
+        deadline = q->stamps[q->head] + subtle->expiry;
+    }
+
+  return deadline;
+} /* }}} */
+
 /* EventQueuePush {{{ */
 static void
 EventQueuePush(XClientMessageEvent *ev,
   long type)
 {
+  int idx = 0;
+  time_t now = subSubtleTime();
+  SubQueue *q = EventQueueFind(type);
+
+  if(!q) return;
+
+  EventQueueExpire(q, now);
+
+  /* Drop oldest entry when full */
+  if(QUEUESIZE == q->nevents)
+    {
+      q->head = (q->head + 1) % QUEUESIZE;
+      q->nevents--;
+      ndropped++;
+
+      subSubtleLogDebugEvents("Queue full: type=%ld, dropped=%lu\n",
+        type, ndropped);
+    }
+
   /* Since we are dealing with race conditions we need to cache
    * client messages when a client/view/tag isn't ready yet */
-  queue = (XClientMessageEvent *)subSharedMemoryRealloc(queue,
-    (nqueue + 1) * sizeof(XClientMessageEvent));
-  queue[nqueue]           = *ev;
-  queue[nqueue].data.l[4] = type; ///< Overwrite pointless timestamp
-  nqueue++;
+  idx = (q->head + q->nevents) % QUEUESIZE;
+
+  q->events[idx]           = *ev;
+  q->events[idx].data.l[4] = type; ///< Overwrite pointless timestamp
+  q->stamps[idx]           = now;
+  q->nevents++;
 
   subSubtleLogDebugEvents("Queue push: id=%ld, data=%ld, type=%ld\n",
     ev->data.l[0], ev->data.l[1], type);
@@ -100,86 +286,46 @@ static void
 EventQueuePop(long value,
   long type)
 {
+  SubQueue *q = EventQueueFind(type);
+
   /* Check queue */
-  if(queue)
+  if(q && 0 < q->nevents)
     {
       int i;
 
-      /* Check queued events */
-      for(i = 0; i < nqueue; i++)
-        {
-          /* Check event type matches */
-          if(queue[i].data.l[4] == type)
-            {
-              int j;
-
-              subSubtleLogDebugEvents("Queue pop: id=%ld, data=%ld, type=%ld\n",
-                queue[i].data.l[0], queue[i].data.l[1], queue[i].data.l[4]);
+      EventQueueExpire(q, subSubtleTime());
 
-              /* Update window id or array index and put back */ 
-              queue[i].data.l[0] = value;
-              XPutBackEvent(subtle->dpy, (XEvent *)&queue[i]);
+      /* Put back in reverse order to keep the order of arrival */
+      for(i = q->nevents - 1; 0 <= i; i--)
+        {
+          XClientMessageEvent *ev = &q->events[(q->head + i) % QUEUESIZE];
 
-              /* Remove element from queue */
-              for(j = i; j < nqueue - 1; j++)
-                queue[j] = queue[j + 1];
+          subSubtleLogDebugEvents("Queue pop: id=%ld, data=%ld, type=%ld\n",
+            ev->data.l[0], ev->data.l[1], ev->data.l[4]);
 
-              nqueue--;
-              queue = (XClientMessageEvent *)subSharedMemoryRealloc(queue,
-                nqueue * sizeof(XClientMessageEvent));
-              i--;
-            }
+          /* Update window id or array index and put back */
+          ev->data.l[0] = value;
+          XPutBackEvent(subtle->dpy, (XEvent *)ev);
         }
+
+      q->head    = 0;
+      q->nevents = 0;
     }
 } /* }}} */
 
-/* EventMatch {{{ */
+/* EventTimeout {{{ */
 static int
-EventMatch(int type,
-  XRectangle *origin,
-  XRectangle *test)
+EventTimeout(time_t deadline,
+  time_t now,
+  int timeout)
 {
-  int cx_origin = 0, cx_test = 0, cy_origin = 0, cy_test = 0, dx = 0, dy = 0;
-
-  /* This check is complicated and consists of three parts:
-   * 1) Calculate window center positions
-   * 2) Check if x/y values decrease in given direction
-   * 3) Check if a corner of one of the rects is close enough to
-   *    a side of the other rect */
-
-  /* Calculate window centers */
-  cx_origin = origin->x + (origin->width / 2);
-  cx_test   = test->x + (test->width / 2);
-
-  cy_origin = origin->y + (origin->height / 2);
-  cy_test   = test->y + (test->height / 2);
-
-  /* Check geometries */
-  if((((SUB_GRAB_DIRECTION_LEFT  == type      && cx_test   <= cx_origin)                  ||
-       (SUB_GRAB_DIRECTION_RIGHT == type      && cx_test   >= cx_origin))                 &&
-       ((cy_test                 >= origin->y && cy_test   <= origin->y + origin->height) ||
-       (cy_origin                >= test->y   && cy_origin <= test->y   + test->height))) ||
-
-     (((SUB_GRAB_DIRECTION_UP    == type      && cy_test   <= cy_origin)                  ||
-       (SUB_GRAB_DIRECTION_DOWN  == type      && cy_test   >= cy_origin))                 &&
-       ((cx_test                 >= origin->x && cx_test   <= origin->x + origin->width)  ||
-       (cx_origin                 >= test->x   && cx_origin <= test->x   + test->width))))
-    {
-      /* Euclidean distance */
-      dx = abs(cx_origin - cx_test);
-      dy = abs(cy_origin - cy_test);
+  int ms = 0;
 
-      /* Zero distance means same dimensions - highest distance */
-      if(0 == dx && 0 == dy) dx = dy = 1L << 15;
-    }
-  else
-    {
-      /* No match - highest distance too */
-      dx = 1L << 15;
-      dy = 1L << 15;
-    }
+  if(0 > deadline) return timeout; ///< No deadline
+
+  ms = deadline > now ? deadline - now : 0;
 
-  return dx + dy;
+  return 0 > timeout || ms < timeout ? ms : timeout;
 } /* }}} */
 
 /* Events */
@@ -276,10 +422,15 @@ EventConfigureRequest(XConfigureRequestEvent *ev)
               !(ev->value_mask & (CWWidth|CWHeight))))
             subClientConfigure(c);
 
-          /* Send real configure notify */
-          if(ev->value_mask & (CWX|CWY|CWWidth|CWHeight))
-            XMoveResizeWindow(subtle->dpy, c->win, c->geom.x, c->geom.y,
-              c->geom.width, c->geom.height);
+          /* Send real configure notify, fall back to a synthetic one when
+           * nothing changed and the server stays quiet */
+          else if(!subClientMoveResize(c, &c->geom))
+            subClientConfigure(c);
+
+          /* Move only */
+          if(ev->value_mask & (CWX|CWY) &&
+              !(ev->value_mask & (CWWidth|CWHeight)))
+            subClientMoveResize(c, &c->geom);
         }
       else subClientConfigure(c);
     }
@@ -352,8 +503,7 @@ EventDestroy(XDestroyWindowEvent *ev)
       subClientPublish(False);
 
       subScreenConfigure();
-      subScreenUpdate();
-      subScreenRender();
+      subScreenDirty(SUB_SUBTLE_UPDATE);
 
       /* Update focus if necessary */
       if((c = subClientNext(sid, False))) subClientFocus(c, True);
@@ -368,8 +518,7 @@ EventDestroy(XDestroyWindowEvent *ev)
       subTrayUpdate();
       subTrayPublish();
 
-      subScreenUpdate();
-      subScreenRender();
+      subScreenDirty(SUB_SUBTLE_UPDATE);
 
       /* Update focus if necessary */
       if(focus && (c = subClientNext(0, False))) subClientFocus(c, True);
@@ -395,7 +544,7 @@ EventDestroy(XDestroyWindowEvent *ev)
 static void
 EventExpose(XExposeEvent *ev)
 {
-  if(0 == ev->count) subScreenRender(); ///< Render once
+  if(0 == ev->count) subScreenDirty(SUB_SUBTLE_RENDER); ///< Render once
 
   subSubtleLogDebugEvents("Expose: win=%#lx\n", ev->window);
 } /* }}} */
@@ -490,8 +639,7 @@ EventGrab(XEvent *ev)
 
           subtle->keychain = NULL;
 
-          subScreenUpdate();
-          subScreenRender();
+          subScreenDirty(SUB_SUBTLE_UPDATE);
 
           /* Restore binds */
           subGrabUnset(ROOT);
@@ -552,8 +700,7 @@ EventGrab(XEvent *ev)
 
               subtle->panels.keychain.keychain->len += len;
 
-              subScreenUpdate();
-              subScreenRender();
+              subScreenDirty(SUB_SUBTLE_UPDATE);
             }  /* }}} */
 
           /* Keep chain position */
@@ -590,8 +737,7 @@ EventGrab(XEvent *ev)
                 if(!(c->flags & SUB_CLIENT_MODE_FLOAT))
                   {
                     subClientToggle(c, SUB_CLIENT_MODE_FLOAT, True);
-                    subScreenUpdate();
-                    subScreenRender();
+                    subScreenDirty(SUB_SUBTLE_UPDATE);
                   }
 
                 /* Translate flags */
@@ -616,8 +762,7 @@ EventGrab(XEvent *ev)
                     if(!VISIBLE(c) && (c = subClientNext(c->screenid, False)))
                       subClientFocus(c, True);
 
-                    subScreenUpdate();
-                    subScreenRender();
+                    subScreenDirty(SUB_SUBTLE_UPDATE);
                   }
               }
             break; /* }}} */
@@ -631,48 +776,27 @@ EventGrab(XEvent *ev)
             {
               SubClient *found = NULL;
 
-              /* Check if a window is currently focussed or just select next*/
-              if((c = CLIENT(subSubtleFind(subtle->windows.focus[0],
-                  CLIENTID))))
+              /* Cycle through focus history of current view */
+              if(SUB_GRAB_DIRECTION_RECENT == g->data.num)
                 {
-                  int i, j, match = (1L << 30), distance = 0;
+                  int sid = 0;
 
-                  /* Iterate once to find a client with smallest distance */
-                  for(i = 0; i < subtle->clients->ndata; i++)
-                    {
-                      SubClient *k = CLIENT(subtle->clients->data[i]);
+                  if((c = CLIENT(subSubtleFind(subtle->windows.focus[0],
+                      CLIENTID))))
+                    sid = c->screenid;
+                  else subScreenCurrent(&sid);
 
-                      /* Check if both clients are different and visible */
-                      if(c != k && (subtle->visible_tags & k->tags ||
-                          k->flags & SUB_CLIENT_MODE_STICK))
-                        {
-                          /* Substract stack position index to get top window */
-                          distance = EventMatch(g->data.num, &c->geom,
-                            &k->geom) - i;
-
-                          /* Substract history stack position index */
-                          for(j = 1; j < HISTORYSIZE; j++)
-                            {
-                              if(subtle->windows.focus[j] == k->win)
-                                {
-                                  distance -= (HISTORYSIZE - j);
-                                  break;
-                                }
-                            }
-
-                          /* Finally compare distance */
-                          if(match > distance)
-                            {
-                              match = distance;
-                              found = k;
-                            }
-                        }
-                    }
-                  }
-                else found = subClientNext(-1, True);
+                  if((s = SCREEN(subArrayGet(subtle->screens, sid))))
+                    found = subClientRecentCycle(s->viewid, sid);
+                }
+              /* Check if a window is currently focussed or just select next*/
+              else if((c = CLIENT(subSubtleFind(subtle->windows.focus[0],
+                  CLIENTID))))
+                found = subClientSelect(c, g->data.num);
+              else found = subClientNext(-1, True);
 
-                if(found) subClientFocus(found, True);
-              }
+              if(found) subClientFocus(found, True);
+            }
             break; /* }}} */
           case SUB_GRAB_WINDOW_GRAVITY: /* {{{ */
             if((c = CLIENT(subSubtleFind(subtle->windows.focus[0], CLIENTID))) &&
@@ -686,8 +810,7 @@ EventGrab(XEvent *ev)
                   {
                     subClientToggle(c, c->flags &
                       (SUB_CLIENT_MODE_FLOAT|SUB_CLIENT_MODE_FULL), True);
-                    subScreenUpdate();
-                    subScreenRender();
+                    subScreenDirty(SUB_SUBTLE_UPDATE);
 
                     c->gravityid = -1; ///< Reset
                   }
@@ -809,8 +932,7 @@ EventMap(XMapEvent *ev)
       t->flags &= ~SUB_TRAY_DEAD;
 
       subTrayUpdate();
-      subScreenUpdate();
-      subScreenRender();
+      subScreenDirty(SUB_SUBTLE_UPDATE);
     }
 
   subSubtleLogDebugEvents("Map: win=%#lx\n", ev->window);
@@ -843,10 +965,10 @@ EventMapRequest(XMapRequestEvent *ev)
     {
       c->flags &= ~SUB_CLIENT_DEAD;
       c->flags |= SUB_CLIENT_ARRANGE;
+      c->state  = -1; ///< Force map
 
       subScreenConfigure();
-      subScreenUpdate();
-      subScreenRender();
+      subScreenDirty(SUB_SUBTLE_UPDATE);
     }
   else if((c = subClientNew(ev->window)))
     {
@@ -854,8 +976,7 @@ EventMapRequest(XMapRequestEvent *ev)
       subClientRestack(c, SUB_CLIENT_RESTACK_UP);
 
       subScreenConfigure();
-      subScreenUpdate();
-      subScreenRender();
+      subScreenDirty(SUB_SUBTLE_UPDATE);
 
       EventQueuePop(ev->window, SUB_TYPE_CLIENT);
 
@@ -978,8 +1099,7 @@ EventMessage(XClientMessageEvent *ev)
                     if(c) subClientFocus(c, True);
                   }
 
-                subScreenUpdate();
-                subScreenRender();
+                subScreenDirty(SUB_SUBTLE_UPDATE);
               }
             else EventQueuePush(ev, SUB_TYPE_CLIENT);
             break; /* }}} */
@@ -997,8 +1117,7 @@ EventMessage(XClientMessageEvent *ev)
                     flags & SUB_CLIENT_MODE_FULL)
                   {
                     subScreenConfigure();
-                    subScreenUpdate();
-                    subScreenRender();
+                    subScreenDirty(SUB_SUBTLE_UPDATE);
                   }
               }
             break; /* }}} */
@@ -1019,7 +1138,7 @@ EventMessage(XClientMessageEvent *ev)
                           printf("DEBUG %s:%d\n", __FILE__, __LINE__);
                             subClientArrange(c,
                               c->gravities[(int)ev->data.l[2]], c->screenid);
-                            XRaiseWindow(subtle->dpy, c->win);
+                            subClientRestack(c, SUB_CLIENT_RESTACK_UP);
 
                             /* Warp pointer */
                             if(!(subtle->flags & SUB_SUBTLE_SKIP_WARP))
@@ -1032,7 +1151,7 @@ EventMessage(XClientMessageEvent *ev)
                     else if(VISIBLE(c))
                       {
                         subClientArrange(c, (int)ev->data.l[1], c->screenid);
-                        XRaiseWindow(subtle->dpy, c->win);
+                        subClientRestack(c, SUB_CLIENT_RESTACK_UP);
 
                         /* Warp pointer */
                         if(!(subtle->flags & SUB_SUBTLE_SKIP_WARP))
@@ -1068,8 +1187,7 @@ EventMessage(XClientMessageEvent *ev)
                     flags & (SUB_CLIENT_MODE_FULL|SUB_CLIENT_MODE_URGENT))
                   {
                     subScreenConfigure();
-                    subScreenUpdate();
-                    subScreenRender();
+                    subScreenDirty(SUB_SUBTLE_UPDATE);
                   }
               }
             else EventQueuePush(ev, SUB_TYPE_CLIENT);
@@ -1112,8 +1230,7 @@ EventMessage(XClientMessageEvent *ev)
                   }
 
                 subScreenConfigure();
-                subScreenUpdate();
-                subScreenRender();
+                subScreenDirty(SUB_SUBTLE_UPDATE);
               }
             break; /* }}} */
           case SUB_EWMH_SUBTLE_GRAVITY_KILL: /* {{{ */
@@ -1127,7 +1244,6 @@ EventMessage(XClientMessageEvent *ev)
                     if((c = CLIENT(subtle->clients->data[i])) && c->gravityid == ev->data.l[0])
                       {
                         subClientArrange(c, 0, -1); ///< Fallback to first gravity
-                        XRaiseWindow(subtle->dpy, c->win);
 
                         /* Warp pointer */
                         if(!(subtle->flags & SUB_SUBTLE_SKIP_WARP))
@@ -1153,8 +1269,7 @@ EventMessage(XClientMessageEvent *ev)
                 p->sublet->flags & SUB_SUBLET_DATA)
               {
                 subRubyCall(SUB_CALL_DATA, p->sublet->instance, NULL);
-                subScreenUpdate();
-                subScreenRender();
+                subScreenDirty(SUB_SUBTLE_DAMAGE);
               }
             break; /* }}} */
           case SUB_EWMH_SUBTLE_SUBLET_STYLE: /* {{{ */
@@ -1172,8 +1287,7 @@ EventMessage(XClientMessageEvent *ev)
                     subStyleFind(&subtle->styles.sublets, name, &styleid);
 
                     p->sublet->styleid = -1 != styleid ? styleid : -1;
-                    subScreenUpdate();
-                    subScreenRender();
+                    subPanelDamage(p);
                   }
               }
             break; /* }}} */
@@ -1185,15 +1299,13 @@ EventMessage(XClientMessageEvent *ev)
                     p->flags & SUB_PANEL_HIDDEN)
                   {
                     p->flags &= ~SUB_PANEL_HIDDEN;
-                    subScreenUpdate();
-                    subScreenRender();
+                    subScreenDirty(SUB_SUBTLE_UPDATE);
                   }
                 else if(ev->data.l[1] & SUB_EWMH_HIDDEN &&
                     !(p->flags & SUB_PANEL_HIDDEN))
                   {
                     p->flags |= SUB_PANEL_HIDDEN;
-                    subScreenUpdate();
-                    subScreenRender();
+                    subScreenDirty(SUB_SUBTLE_UPDATE);
                   }
               }
             break; /* }}} */
@@ -1201,16 +1313,14 @@ EventMessage(XClientMessageEvent *ev)
             if((p = EventFindSublet((int)ev->data.l[0])))
               {
                 subRubyCall(SUB_CALL_RUN, p->sublet->instance, NULL);
-                subScreenUpdate();
-                subScreenRender();
+                subScreenDirty(SUB_SUBTLE_DAMAGE);
               }
             break; /* }}} */
           case SUB_EWMH_SUBTLE_SUBLET_KILL: /* {{{ */
             if((p = EventFindSublet((int)ev->data.l[0])))
               {
                 subRubyUnloadSublet(p);
-                subScreenUpdate();
-                subScreenRender();
+                subScreenDirty(SUB_SUBTLE_UPDATE);
               }
             break; /* }}} */
           case SUB_EWMH_SUBTLE_TAG_NEW: /* {{{ */
@@ -1263,8 +1373,7 @@ EventMessage(XClientMessageEvent *ev)
                 subArrayPush(subtle->views, (void *)v);
                 subClientDimension(-1); ///< Grow
                 subViewPublish();
-                subScreenUpdate();
-                subScreenRender();
+                subScreenDirty(SUB_SUBTLE_UPDATE);
 
                 EventQueuePop(subtle->views->ndata - 1, SUB_TYPE_VIEW);
 
@@ -1302,8 +1411,7 @@ EventMessage(XClientMessageEvent *ev)
                     subStyleFind(&subtle->styles.views, name, &style_id);
 
                     v->styleid = -1 != style_id ? style_id : -1;
-                    subScreenUpdate();
-                    subScreenRender();
+                    subScreenDirty(SUB_SUBTLE_UPDATE);
                   }
               }
             break; /* }}} */
@@ -1316,15 +1424,14 @@ EventMessage(XClientMessageEvent *ev)
                 subClientDimension((int)ev->data.l[0]); ///< Shrink
                 subViewKill(v);
                 subViewPublish();
-                subScreenUpdate();
-                subScreenRender();
+                subScreenDirty(SUB_SUBTLE_UPDATE);
 
                 if(visible)
                   subViewFocus(VIEW(subtle->views->data[0]), -1, False, True);
               }
             break; /* }}} */
           case SUB_EWMH_SUBTLE_RENDER: /* {{{ */
-            subScreenRender();
+            subScreenDirty(SUB_SUBTLE_RENDER);
             break; /* }}} */
           case SUB_EWMH_SUBTLE_RELOAD: /* {{{ */
             if(subtle) subtle->flags |= SUB_SUBTLE_RELOAD;
@@ -1339,6 +1446,9 @@ EventMessage(XClientMessageEvent *ev)
           case SUB_EWMH_SUBTLE_QUIT: /* {{{ */
             if(subtle) subtle->flags &= ~SUB_SUBTLE_RUN;
             break; /* }}} */
+          case SUB_EWMH_SUBTLE_STATS: /* {{{ */
+            subStatsPublish(False);
+            break; /* }}} */
           default: break;
         }
     } /* }}} */
@@ -1358,8 +1468,7 @@ EventMessage(XClientMessageEvent *ev)
                           subArrayPush(subtle->trays, (void *)r);
                           subTrayPublish();
                           subTrayUpdate();
-                          subScreenUpdate();
-                          subScreenRender();
+                          subScreenDirty(SUB_SUBTLE_UPDATE);
                         }
                     }
                   break; /* }}} */
@@ -1424,8 +1533,7 @@ EventMessage(XClientMessageEvent *ev)
                         if(c) subClientFocus(c, True);
                       }
 
-                    subScreenUpdate();
-                    subScreenRender();
+                    subScreenDirty(SUB_SUBTLE_UPDATE);
                   }
               }
             break; /* }}} */
@@ -1445,14 +1553,11 @@ EventMessage(XClientMessageEvent *ev)
                 c->geom.height = ev->data.l[4];
 
                 subClientResize(c, &(s->geom), True);
-
-                XMoveResizeWindow(subtle->dpy, c->win, c->geom.x, c->geom.y,
-                  c->geom.width, c->geom.height);
+                subClientMoveResize(c, &c->geom);
 
                 if(VISIBLE(c))
                   {
-                    subScreenUpdate();
-                    subScreenRender();
+                    subScreenDirty(SUB_SUBTLE_UPDATE);
                   }
               }
             break; /* }}} */
@@ -1498,8 +1603,7 @@ EventProperty(XPropertyEvent *ev)
 
             if(subtle->windows.focus[0] == c->win)
               {
-                subScreenUpdate();
-                subScreenRender();
+                subScreenDirty(SUB_SUBTLE_UPDATE);
               }
           }
         break; /* }}} */
@@ -1513,16 +1617,14 @@ EventProperty(XPropertyEvent *ev)
 
             if(VISIBLE(c))
               {
-                subScreenUpdate();
-                subScreenRender();
+                subScreenDirty(SUB_SUBTLE_UPDATE);
               }
           }
         else if((t = TRAY(subSubtleFind(ev->window, TRAYID))))
           {
             subTrayConfigure(t);
             subTrayUpdate();
-            subScreenUpdate();
-            subScreenRender();
+            subScreenDirty(SUB_SUBTLE_UPDATE);
           }
         break; /* }}} */
       case SUB_EWMH_WM_HINTS: /* {{{ */
@@ -1538,8 +1640,7 @@ EventProperty(XPropertyEvent *ev)
             if(VISIBLE(c) ||
                 flags & SUB_CLIENT_MODE_URGENT)
               {
-                subScreenUpdate();
-                subScreenRender();
+                subScreenDirty(SUB_SUBTLE_UPDATE);
               }
           }
         break; /* }}} */
@@ -1547,7 +1648,7 @@ EventProperty(XPropertyEvent *ev)
          if((c = CLIENT(subSubtleFind(ev->window, CLIENTID))))
           {
             subClientSetStrut(c);
-            subScreenUpdate();
+            subScreenDirty(SUB_SUBTLE_UPDATE);
             subSubtleLogDebug("Hints: Updated strut hints\n");
           }
         break; /* }}} */
@@ -1560,8 +1661,7 @@ EventProperty(XPropertyEvent *ev)
           {
             subTraySetState(t);
             subTrayUpdate();
-            subScreenUpdate();
-            subScreenRender();
+            subScreenDirty(SUB_SUBTLE_UPDATE);
           }
         break; /* }}} */
     }
@@ -1610,10 +1710,7 @@ EventUnmap(XUnmapEvent *ev)
     {
       int sid = (subtle->windows.focus[0] == c->win ? c->screenid : -1); ///< Save
 
-      /* Set withdrawn state (see ICCCM 4.1.4) */
-      subEwmhSetWMState(c->win, WithdrawnState);
-
-      /* Ignore our generated unmap events */
+      /* Ignore our generated unmap events, state is already set */
       if(c->flags & SUB_CLIENT_UNMAP)
         {
           c->flags &= ~SUB_CLIENT_UNMAP;
@@ -1621,14 +1718,16 @@ EventUnmap(XUnmapEvent *ev)
           return;
         }
 
+      /* Set withdrawn state (see ICCCM 4.1.4) */
+      subEwmhSetWMState(c->win, WithdrawnState);
+
       /*  Kill client */
       subArrayRemove(subtle->clients, (void *)c);
       subClientKill(c);
       subClientPublish(False);
 
       subScreenConfigure();
-      subScreenUpdate();
-      subScreenRender();
+      subScreenDirty(SUB_SUBTLE_UPDATE);
 
       /* Update focus if necessary */
       if((c = subClientNext(sid, False))) subClientFocus(c, True);
@@ -1654,8 +1753,7 @@ EventUnmap(XUnmapEvent *ev)
       subTrayUpdate();
       subTrayPublish();
 
-      subScreenUpdate();
-      subScreenRender();
+      subScreenDirty(SUB_SUBTLE_UPDATE);
 
       /* Update focus if necessary */
       if(focus && (c = subClientNext(0, False))) subClientFocus(c, True);
@@ -1664,23 +1762,294 @@ EventUnmap(XUnmapEvent *ev)
   subSubtleLogDebugEvents("Unmap: win=%#lx\n", ev->window);
 } /* }}} */
 
+/* EventXMark {{{ */
+static SubMark *
+EventXMark(Window win,
+  Atom atom,
+  int create)
+{
+  unsigned int i = ((unsigned int)win * 31 ^ (unsigned int)atom) &
+    (MARKSIZE - 1);
+
+  /* Linear probing, table is at most half full */
+  for(; None != marks[i].win; i = (i + 1) & (MARKSIZE - 1))
+    if(marks[i].win == win && marks[i].atom == atom) return &marks[i];
+
+  if(!create || MARKSIZE / 2 <= nmarks) return NULL;
+
+  marks[i].win  = win;
+  marks[i].atom = atom;
+  nmarks++;
+
+  return &marks[i];
+} /* }}} */
+
+/* EventXScan {{{ */
+static Bool
+EventXScan(Display *dpy,
+  XEvent *ev,
+  XPointer arg)
+{
+  SubMark *m = NULL;
+
+  /* Count property changes per window and atom, never remove anything */
+  if(BATCHSIZE > nscan++ && PropertyNotify == ev->type &&
+      (m = EventXMark(ev->xproperty.window, ev->xproperty.atom, True)))
+    m->count++;
+
+  return False;
+} /* }}} */
+
+/* EventXAhead {{{ */
+static Bool
+EventXAhead(Display *dpy,
+  XEvent *ev,
+  XPointer arg)
+{
+  SubAhead *ahead = (SubAhead *)arg;
+
+  if(ahead->blocked) return False;
+
+  /* Presses and the focus changes they cause overtake everything but
+   * other input; releases, motion and crossings keep their order */
+  switch(ev->type)
+    {
+      case KeyPress:
+      case ButtonPress:
+      case FocusIn:
+      case FocusOut:      return True;
+      case KeyRelease:
+      case ButtonRelease:
+      case MotionNotify:
+      case EnterNotify:
+      case LeaveNotify:
+        ahead->blocked = True;
+
+        return False;
+    }
+
+  ahead->skipped++;
+
+  return False;
+} /* }}} */
+
+/* EventX {{{ */
+static void
+EventX(void)
+{
+  int n;
+  unsigned long start = 0;
+  XEvent ev;
+  SubMark *m = NULL;
+  SubAhead ahead;
+
+  while(XPending(subtle->dpy)) ///< X events
+    {
+      /* Mark pending property changes */
+      memset(marks, 0, sizeof(marks));
+      nmarks = nscan = 0;
+
+      XCheckIfEvent(subtle->dpy, &ev, EventXScan, NULL);
+
+      n = MIN(nscan, BATCHSIZE);
+
+      /* Input first, as long as no other input is queued before.. */
+      while(0 < n && (memset(&ahead, 0, sizeof(SubAhead)),
+          XCheckIfEvent(subtle->dpy, &ev, EventXAhead, (XPointer)&ahead)))
+        {
+          if(subtle->flags & SUB_SUBTLE_RECORD) subRecordEvent(&ev);
+
+          start = subStatsTime();
+
+          subEventDispatch(&ev);
+          n--;
+
+          /* Count presses that overtook queued events */
+          if(0 < ahead.skipped && (KeyPress == ev.type ||
+              ButtonPress == ev.type))
+            subStatsAhead(start);
+        }
+
+      /* ..and then the rest in order, nested readers may have taken some */
+      for(; 0 < n && XEventsQueued(subtle->dpy, QueuedAlready); n--)
+        {
+          XNextEvent(subtle->dpy, &ev);
+
+          if(subtle->flags & SUB_SUBTLE_RECORD) subRecordEvent(&ev);
+
+          /* Only last change of a property matters */
+          if(PropertyNotify == ev.type && (m = EventXMark(ev.xproperty.window,
+              ev.xproperty.atom, False)) && 0 < --m->count)
+            continue;
+
+          subEventDispatch(&ev);
+        }
+    }
+} /* }}} */
+
+#ifdef HAVE_SYS_INOTIFY_H
+/* EventNotifyMark {{{ */
+static void
+EventNotifyMark(SubArray *pending,
+  SubPanel *p)
+{
+  /* Call each sublet only once per wakeup */
+  if(p && !(p->sublet->flags & SUB_SUBLET_PENDING))
+    {
+      p->sublet->flags |= SUB_SUBLET_PENDING;
+
+      subArrayPush(pending, (void *)p);
+    }
+} /* }}} */
+
+/* EventNotify {{{ */
+static void
+EventNotify(void)
+{
+  int i;
+  ssize_t len = 0, offset = 0;
+  char buf[BUFLEN] __attribute__((aligned(__alignof__(struct inotify_event))));
+  SubArray *pending = subArrayNew();
+
+  /* Drain all inotify events */
+  while(0 < (len = read(subtle->notify, buf, BUFLEN)))
+    {
+      for(offset = 0; offset < len; offset += sizeof(struct inotify_event) +
+          ((struct inotify_event *)&buf[offset])->len)
+        {
+          struct inotify_event *event = (struct inotify_event *)&buf[offset];
+
+          /* Skip unwatch events */
+          if(IN_IGNORED & event->mask) continue;
+
+          /* Events were lost, so check all watching sublets */
+          if(IN_Q_OVERFLOW & event->mask)
+            {
+              for(i = 0; i < subtle->sublets->ndata; i++)
+                {
+                  SubPanel *p = PANEL(subtle->sublets->data[i]);
+
+                  if(p->sublet->flags & SUB_SUBLET_INOTIFY)
+                    EventNotifyMark(pending, p);
+                }
+            }
+          else EventNotifyMark(pending,
+            PANEL(subSubtleFind(subtle->windows.support, event->wd)));
+        }
+    }
+
+  /* Run watch callbacks */
+  for(i = 0; i < pending->ndata; i++)
+    {
+      SubPanel *p = PANEL(pending->data[i]);
+
+      p->sublet->flags &= ~SUB_SUBLET_PENDING;
+
+      subRubyCall(SUB_CALL_WATCH, p->sublet->instance, NULL);
+    }
+
+  if(0 < pending->ndata) subScreenDirty(SUB_SUBTLE_DAMAGE);
+
+  subSubtleLogDebugEvents("Inotify: sublets=%d\n", pending->ndata);
+
+  subArrayKill(pending, False);
+} /* }}} */
+#endif /* HAVE_SYS_INOTIFY_H */
+
+/* EventWatch {{{ */
+static void
+EventWatch(void *data)
+{
+  /* Dispatch directly on data of watch */
+  if((void *)subtle->dpy == data) EventX();
+#ifdef HAVE_SYS_INOTIFY_H
+  else if((void *)&subtle->notify == data) EventNotify();
+#endif /* HAVE_SYS_INOTIFY_H */
+  else if(data) ///< Socket
+    {
+      SubPanel *p = PANEL(data);
+
+      subRubyCall(SUB_CALL_WATCH, p->sublet->instance, NULL);
+      subScreenDirty(SUB_SUBTLE_DAMAGE);
+    }
+} /* }}} */
+
 /* Public */
 
+ /** subEventDispatch {{{
+  * @brief Dispatch event to handler
+  * @param[in]  ev  A #XEvent
+  **/
+
+void
+subEventDispatch(XEvent *ev)
+{
+  unsigned long start = subStatsTime();
+
+  subStatsStallEnter(ev->type, False, NULL);
+
+  switch(ev->type)
+    {
+      case ColormapNotify:    EventColormap(&ev->xcolormap);                  break;
+      case ConfigureNotify:   EventConfigure(&ev->xconfigure);                break;
+      case ConfigureRequest:  EventConfigureRequest(&ev->xconfigurerequest);  break;
+      case EnterNotify:
+      case LeaveNotify:       EventCrossing(&ev->xcrossing);                  break;
+      case DestroyNotify:     EventDestroy(&ev->xdestroywindow);              break;
+      case Expose:            EventExpose(&ev->xexpose);                      break;
+      case FocusIn:           EventFocus(&ev->xfocus);                        break;
+      case ButtonPress:
+      case KeyPress:          EventGrab(ev);                                  break;
+      case MapNotify:         EventMap(&ev->xmap);                            break;
+      case MappingNotify:     EventMapping(&ev->xmapping);                    break;
+      case MapRequest:        EventMapRequest(&ev->xmaprequest);              break;
+      case ClientMessage:     EventMessage(&ev->xclient);                     break;
+      case PropertyNotify:    EventProperty(&ev->xproperty);                  break;
+      case SelectionClear:    EventSelection(&ev->xselectionclear);           break;
+      case UnmapNotify:       EventUnmap(&ev->xunmap);                        break;
+      default: break;
+    }
+
+  subStatsStallLeave();
+  subStatsEvent(ev->type, start);
+} /* }}} */
+
  /** subEventWatchAdd {{{
   * @brief Add descriptor to watch list
-  * @param[in]  fd  File descriptor
+  * @param[in]  fd    File descriptor
+  * @param[in]  data  Data passed to handler when fd is ready
   **/
 
 void
-subEventWatchAdd(int fd)
+subEventWatchAdd(int fd,
+  void *data)
 {
+#ifdef HAVE_SYS_EPOLL_H
+  /* Create epoll instance on first use or fall back to poll */
+  if(-2 == epfd && -1 == (epfd = epoll_create1(EPOLL_CLOEXEC)))
+    subSubtleLogWarn("Cannot create epoll instance, using poll\n");
+
+  if(0 <= epfd)
+    {
+      struct epoll_event event = { 0 };
+
+      event.events   = EPOLLIN;
+      event.data.ptr = data;
+
+      epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event);
+    }
+#endif /* HAVE_SYS_EPOLL_H */
+
   /* Add descriptor to list */
   watches = (struct pollfd *)subSharedMemoryRealloc(watches,
     (nwatches + 1) * sizeof(struct pollfd));
+  watchdata = (void **)subSharedMemoryRealloc(watchdata,
+    (nwatches + 1) * sizeof(void *));
 
-  watches[nwatches].fd        = fd;
-  watches[nwatches].events    = POLLIN;
-  watches[nwatches++].revents = 0;
+  watches[nwatches].fd      = fd;
+  watches[nwatches].events  = POLLIN;
+  watches[nwatches].revents = 0;
+  watchdata[nwatches++]     = data;
 } /* }}} */
 
  /** subEventWatchDel {{{
@@ -1697,15 +2066,107 @@ subEventWatchDel(int fd)
     {
       if(watches[i].fd == fd)
         {
+#ifdef HAVE_SYS_EPOLL_H
+          if(0 <= epfd)
+            {
+              struct epoll_event event = { 0 };
+
+              epoll_ctl(epfd, EPOLL_CTL_DEL, fd, &event);
+
+              /* Drop pending events of this watch */
+              for(j = 0; j < nready; j++)
+                if(events[j].data.ptr == watchdata[i])
+                  events[j].data.ptr = NULL;
+            }
+#endif /* HAVE_SYS_EPOLL_H */
+
           for(j = i; j < nwatches - 1; j++)
-            watches[j] = watches[j + 1];
+            {
+              watches[j]   = watches[j + 1];
+              watchdata[j] = watchdata[j + 1];
+            }
+
+          nwatches--;
+          watches = (struct pollfd *)subSharedMemoryRealloc(watches,
+            nwatches * sizeof(struct pollfd));
+          watchdata = (void **)subSharedMemoryRealloc(watchdata,
+            nwatches * sizeof(void *));
           break;
         }
     }
+} /* }}} */
 
-  nwatches--;
-  watches = (struct pollfd *)subSharedMemoryRealloc(watches,
-    nwatches * sizeof(struct pollfd));
+ /** subEventTimerAdd {{{
+  * @brief Schedule next run of sublet and add it to timer queue
+  * @param[in]  p  A #SubPanel
+  **/
+
+void
+subEventTimerAdd(SubPanel *p)
+{
+  time_t now, wall;
+
+  assert(p && p->flags & SUB_PANEL_SUBLET && 0 < p->sublet->interval);
+
+  /* Align deadline to wall clock boundaries of the interval plus phase */
+  now  = subSubtleTime();
+  wall = subSubtleWallTime() - EventTimerPhase(p->sublet);
+
+  subEventTimerAt(p, now + p->sublet->interval - wall % p->sublet->interval);
+} /* }}} */
+
+ /** subEventTimerAt {{{
+  * @brief Schedule next run of sublet at given time
+  * @param[in]  p     A #SubPanel
+  * @param[in]  time  Monotonic time in ms
+  **/
+
+void
+subEventTimerAt(SubPanel *p,
+  time_t time)
+{
+  assert(p && p->flags & SUB_PANEL_SUBLET);
+
+  p->sublet->time = time;
+
+  /* Append new timers */
+  if(-1 == p->sublet->timer)
+    {
+      timers = (SubPanel **)subSharedMemoryRealloc(timers,
+        (ntimers + 1) * sizeof(SubPanel *));
+      timers[ntimers]  = p;
+      p->sublet->timer = ntimers++;
+    }
+
+  /* Restore heap order */
+  EventTimerDown(EventTimerUp(p->sublet->timer));
+} /* }}} */
+
+ /** subEventTimerDel {{{
+  * @brief Del sublet from timer queue
+  * @param[in]  p  A #SubPanel
+  **/
+
+void
+subEventTimerDel(SubPanel *p)
+{
+  int idx;
+
+  assert(p && p->flags & SUB_PANEL_SUBLET);
+
+  if(-1 != (idx = p->sublet->timer))
+    {
+      p->sublet->timer = -1;
+
+      /* Fill gap with last timer */
+      if(idx != --ntimers)
+        {
+          timers[idx] = timers[ntimers];
+          timers[idx]->sublet->timer = idx;
+
+          EventTimerDown(EventTimerUp(idx));
+        }
+    }
 } /* }}} */
 
  /** subEventLoop {{{
@@ -1715,16 +2176,11 @@ subEventWatchDel(int fd)
 void
 subEventLoop(void)
 {
-  int i, timeout = 1, nevents = 0;
-  XEvent ev;
-  time_t now;
+  int i, timeout = 0, next = -1;
+  time_t now, deadline;
   SubPanel *p = NULL;
   SubClient *c = NULL;
 
-#ifdef HAVE_SYS_INOTIFY_H
-  char buf[BUFLEN];
-#endif /* HAVE_SYS_INOTIFY_H */
-
   /* Update screens and panels */
   subScreenConfigure();
   subScreenUpdate();
@@ -1732,9 +2188,9 @@ subEventLoop(void)
   subPanelPublish();
 
   /* Add watches */
-  subEventWatchAdd(ConnectionNumber(subtle->dpy));
+  subEventWatchAdd(ConnectionNumber(subtle->dpy), (void *)subtle->dpy);
 #ifdef HAVE_SYS_INOTIFY_H
-  subEventWatchAdd(subtle->notify);
+  subEventWatchAdd(subtle->notify, (void *)&subtle->notify);
 #endif /* HAVE_SYS_INOTIFY_H */
 
   /* Set tray selection */
@@ -1745,17 +2201,20 @@ subEventLoop(void)
 
   /* Set grabs and focus first client if any */
   subGrabSet(ROOT, SUB_GRAB_KEY);
-  c = subClientNext(0, False);
+  if(!(c = CLIENT(subSubtleFind(subtle->windows.focus[0], CLIENTID))) ||
+      !VISIBLE(c))
+    c = subClientNext(0, False);
   if(c) subClientFocus(c, True);
 
   /* Hook: Start */
   subHookCall(SUB_HOOK_START, NULL);
 
+  /* Start recording or replaying */
+  if(subtle->flags & (SUB_SUBTLE_RECORD|SUB_SUBTLE_REPLAY)) subRecordInit();
+
   /* Start main loop */
   while(subtle && subtle->flags & SUB_SUBTLE_RUN)
     {
-      now = subSubtleTime();
-
       /* Check if we need to reload */
       if(subtle->flags & SUB_SUBTLE_RELOAD)
         {
@@ -1771,114 +2230,85 @@ subEventLoop(void)
             subTraySelect();
         }
 
-      /* Data ready on any connection */
-      if(0 < (nevents = poll(watches, nwatches, timeout * 1000)))
+      /* Check if stats were requested */
+      if(subtle->flags & SUB_SUBTLE_STATS)
         {
-          for(i = 0; i < nwatches; i++) ///< Find descriptor
-            {
-              if(0 != watches[i].revents)
-                {
-                  if(watches[i].fd == ConnectionNumber(subtle->dpy)) ///< X events {{{
-                    {
-                      while(XPending(subtle->dpy)) ///< X events
-                        {
-                          XNextEvent(subtle->dpy, &ev);
-                          switch(ev.type)
-                            {
-                              case ColormapNotify:    EventColormap(&ev.xcolormap);                 break;
-                              case ConfigureNotify:   EventConfigure(&ev.xconfigure);               break;
-                              case ConfigureRequest:  EventConfigureRequest(&ev.xconfigurerequest); break;
-                              case EnterNotify:
-                              case LeaveNotify:       EventCrossing(&ev.xcrossing);                 break;
-                              case DestroyNotify:     EventDestroy(&ev.xdestroywindow);             break;
-                              case Expose:            EventExpose(&ev.xexpose);                     break;
-                              case FocusIn:           EventFocus(&ev.xfocus);                       break;
-                              case ButtonPress:
-                              case KeyPress:          EventGrab(&ev);                               break;
-                              case MapNotify:         EventMap(&ev.xmap);                           break;
-                              case MappingNotify:     EventMapping(&ev.xmapping);                   break;
-                              case MapRequest:        EventMapRequest(&ev.xmaprequest);             break;
-                              case ClientMessage:     EventMessage(&ev.xclient);                    break;
-                              case PropertyNotify:    EventProperty(&ev.xproperty);                 break;
-                              case SelectionClear:    EventSelection(&ev.xselectionclear);          break;
-                              case UnmapNotify:       EventUnmap(&ev.xunmap);                       break;
-                              default: break;
-                            }
-                        }
-                    } /* }}} */
-#ifdef HAVE_SYS_INOTIFY_H
-                  else if(watches[i].fd == subtle->notify) ///< Inotify {{{
-                    {
-                      if(0 < read(subtle->notify, buf, BUFLEN)) ///< Inotify events
-                        {
-                          struct inotify_event *event = (struct inotify_event *)&buf[0];
-
-                          /* Skip unwatch events */
-                          if(event && IN_IGNORED != event->mask)
-                            {
-                              if((p = PANEL(subSubtleFind(
-                                  subtle->windows.support, event->wd))))
-                                {
-                                  subRubyCall(SUB_CALL_WATCH,
-                                    p->sublet->instance, NULL);
-                                  subScreenUpdate();
-                                  subScreenRender();
-                                }
-                            }
-                        }
-                    } /* }}} */
-#endif /* HAVE_SYS_INOTIFY_H */
-                  else ///< Socket {{{
-                    {
-                      if((p = PANEL(subSubtleFind(subtle->windows.support,
-                          watches[i].fd))))
-                        {
-                          subRubyCall(SUB_CALL_WATCH,
-                            p->sublet->instance, NULL);
-                          subScreenUpdate();
-                          subScreenRender();
-                        }
-                    } /* }}} */
-                }
-            }
+          subtle->flags &= ~SUB_SUBTLE_STATS;
+          subStatsPublish(True);
         }
-      else if(0 == nevents) ///< Timeout waiting for data or error {{{
+
+      /* Wait for data on any connection */
+#ifdef HAVE_SYS_EPOLL_H
+      if(0 <= epfd)
         {
-          if(0 < subtle->sublets->ndata)
+          if(0 < (nready = epoll_wait(epfd, events, NEVENTS, timeout)))
             {
-              p = PANEL(subtle->sublets->data[0]);
+              for(i = 0; i < nready; i++) ///< Only ready descriptors
+                if(events[i].data.ptr) EventWatch(events[i].data.ptr);
+            }
 
-              /* Update all pending sublets */
-              while(p && p->sublet->flags & SUB_SUBLET_INTERVAL &&
-                  p->sublet->time <= now)
-                {
-                  subRubyCall(SUB_CALL_RUN, p->sublet->instance, NULL);
+          nready = 0;
+        }
+      else
+#endif /* HAVE_SYS_EPOLL_H */
+      if(0 < poll(watches, nwatches, timeout))
+        {
+          for(i = 0; i < nwatches; i++) ///< Find descriptor
+            if(0 != watches[i].revents) EventWatch(watchdata[i]);
+        }
 
-                  /* This may change during run */
-                  if(p->sublet->flags & SUB_SUBLET_INTERVAL) 
-                    {
-                      p->sublet->time  = now + p->sublet->interval; ///< Adjust seconds
-                      p->sublet->time -= p->sublet->time % p->sublet->interval;
-                    }
+      /* Handle events Xlib queued while handling other watches */
+      if(XEventsQueued(subtle->dpy, QueuedAlready)) EventX();
 
-                  subArraySort(subtle->sublets, subPanelCompare);
-                }
+      /* Run all due sublets, even when busy with other events {{{ */
+      if(0 < ntimers && timers[0]->sublet->time <= (now = subSubtleTime()))
+        {
+          while(0 < ntimers && (p = timers[0])->sublet->time <= now)
+            {
+              subRubyCall(SUB_CALL_RUN, p->sublet->instance, NULL);
 
-              subScreenUpdate();
-              subScreenRender();
+              /* This may change during run */
+              if(p->sublet->flags & SUB_SUBLET_INTERVAL)
+                subEventTimerAdd(p);
+              else subEventTimerDel(p);
             }
+
+          subScreenDirty(SUB_SUBTLE_DAMAGE);
         } /* }}} */
 
-      /* Set new timeout */
-      if(0 < subtle->sublets->ndata)
+      /* Drop stale queued messages when due */
+      if(0 <= (deadline = EventQueueDeadline()) &&
+          deadline <= (now = subSubtleTime()))
         {
-          p = PANEL(subtle->sublets->data[0]);
-
-          timeout = p->sublet->flags & SUB_SUBLET_INTERVAL ?
-            p->sublet->time - now : 60;
-          if(0 >= timeout) timeout = 1; ///< Sanitize
+          for(i = 0; i < LENGTH(queues); i++)
+            EventQueueExpire(&queues[i], now);
         }
-      else timeout = 60;
+
+      /* Feed due records of replay */
+      if(subtle->flags & SUB_SUBTLE_REPLAY) next = subRecordReplay();
+
+      /* Apply layouts, publish stacking, update and render once per batch */
+      subLayoutFlush();
+      subClientPublishStacking();
+      subScreenFlush();
+
+      /* Send all requests of this batch at once */
+      XFlush(subtle->dpy);
+
+      /* Arm next wakeup from earliest deadline or block until
+       * something happens when nothing is due at all */
+      now     = subSubtleTime();
+      timeout = -1;
+
+      if(0 < ntimers)
+        timeout = EventTimeout(timers[0]->sublet->time, now, timeout);
+
+      timeout = EventTimeout(EventQueueDeadline(), now, timeout);
+
+      if(0 <= next) timeout = EventTimeout(now + next, now, timeout);
+
+      /* Do not block while Xlib has queued events */
+      if(XEventsQueued(subtle->dpy, QueuedAlready)) timeout = 0;
     }
 
   /* Drop tray selection */
@@ -1893,8 +2323,13 @@ void
 subEventFinish(void)
 {
 
-  if(watches) free(watches);
-  if(queue)   free(queue);
+  if(watches)   free(watches);
+  if(watchdata) free(watchdata);
+  if(timers)    free(timers);
+
+#ifdef HAVE_SYS_EPOLL_H
+  if(0 <= epfd) close(epfd);
+#endif /* HAVE_SYS_EPOLL_H */
 } /* }}} */
 
 // vim:ts=2:bs=2:sw=2:et:fdm=marker
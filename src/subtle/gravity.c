@@ -165,8 +165,6 @@ subGravityPublish(void)
   for(i = 0; i < subtle->gravities->ndata; i++)
     free(gravities[i]);
 
-  XSync(subtle->dpy, False); ///< Sync all changes
-
   free(gravities);
 
   subSubtleLogDebugSubtle("Publish: gravities=%d\n", subtle->gravities->ndata);
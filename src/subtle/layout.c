@@ -0,0 +1,266 @@
+
+ /**
+  * @package subtle
+  *
+  * @file Layout functions
+  * @copyright (c) 2005-2013 Christoph Kappel <unexist@subforge.org>
+  * @version $Id$
+  *
+  * This program can be distributed under the terms of the GNU GPLv2.
+  * See the file COPYING for details.
+  **/
+
+#include "subtle.h"
+
+#define MASTERRATIO 55                           ///< Master width in percent
+
+/* Typedef {{{ */
+typedef void (*SubLayoutFunc)(XRectangle *area, XRectangle *geoms,
+  int n);                                        ///< Layout function
+
+typedef struct sublayout_t
+{
+  const char    *name;                           ///< Layout name
+  SubLayoutFunc func;                            ///< Layout function
+} SubLayout;
+/* }}} */
+
+/* LayoutSplit {{{ */
+static void
+LayoutSplit(XRectangle *area,
+  XRectangle *geoms,
+  int n,
+  int horz)
+{
+  int i, calc = 0, fix = 0;
+
+  /* Split area into equal parts, last one gets rounding fix */
+  calc = (horz ? area->width : area->height) / n;
+  fix  = (horz ? area->width : area->height) - calc * n;
+
+  for(i = 0; i < n; i++)
+    {
+      geoms[i] = *area;
+
+      if(horz)
+        {
+          geoms[i].x     = area->x + i * calc;
+          geoms[i].width = i == n - 1 ? calc + fix : calc;
+        }
+      else
+        {
+          geoms[i].y      = area->y + i * calc;
+          geoms[i].height = i == n - 1 ? calc + fix : calc;
+        }
+    }
+} /* }}} */
+
+/* LayoutMaster {{{ */
+static void
+LayoutMaster(XRectangle *area,
+  XRectangle *geoms,
+  int n)
+{
+  XRectangle stack = *area;
+
+  if(1 == n)
+    {
+      geoms[0] = *area;
+
+      return;
+    }
+
+  /* Master on the left, stack on the right */
+  geoms[0]       = *area;
+  geoms[0].width = area->width * MASTERRATIO / 100;
+
+  stack.x     += geoms[0].width;
+  stack.width -= geoms[0].width;
+
+  LayoutSplit(&stack, geoms + 1, n - 1, False);
+} /* }}} */
+
+/* LayoutGrid {{{ */
+static void
+LayoutGrid(XRectangle *area,
+  XRectangle *geoms,
+  int n)
+{
+  int i, cols = 1, rows = 0;
+
+  /* Smallest square that fits all clients */
+  while(cols * cols < n) cols++;
+  rows = (n + cols - 1) / cols;
+
+  /* Split rows, last row takes remaining clients */
+  LayoutSplit(area, geoms, rows, False);
+
+  for(i = rows - 1; 0 <= i; i--)
+    {
+      XRectangle row = geoms[i];
+
+      LayoutSplit(&row, geoms + i * cols,
+        i == rows - 1 ? n - i * cols : cols, True);
+    }
+} /* }}} */
+
+/* LayoutSpiral {{{ */
+static void
+LayoutSpiral(XRectangle *area,
+  XRectangle *geoms,
+  int n)
+{
+  int i;
+  XRectangle rest = *area;
+
+  /* Each client takes half of the remaining area */
+  for(i = 0; i < n - 1; i++)
+    {
+      geoms[i] = rest;
+
+      if(0 == i % 2)
+        {
+          geoms[i].width = rest.width / 2;
+          rest.x        += geoms[i].width;
+          rest.width    -= geoms[i].width;
+        }
+      else
+        {
+          geoms[i].height = rest.height / 2;
+          rest.y         += geoms[i].height;
+          rest.height    -= geoms[i].height;
+        }
+    }
+
+  geoms[n - 1] = rest;
+} /* }}} */
+
+/* LayoutColumns {{{ */
+static void
+LayoutColumns(XRectangle *area,
+  XRectangle *geoms,
+  int n)
+{
+  LayoutSplit(area, geoms, n, True);
+} /* }}} */
+
+/* Globals */
+SubLayout layouts[] = {
+  { "master",  LayoutMaster  },
+  { "grid",    LayoutGrid    },
+  { "spiral",  LayoutSpiral  },
+  { "columns", LayoutColumns }
+};
+
+/* LayoutApply {{{ */
+static void
+LayoutApply(int screenid)
+{
+  int i, n = 0;
+  SubScreen *s = SCREEN(subArrayGet(subtle->screens, screenid));
+  SubView *v = NULL;
+  SubClient **clients = NULL;
+  XRectangle *geoms = NULL;
+
+  if(!s || !(v = VIEW(subArrayGet(subtle->views, s->viewid))) ||
+      -1 == v->layout)
+    return;
+
+  clients = (SubClient **)subSharedMemoryAlloc(subtle->clients->ndata + 1,
+    sizeof(SubClient *));
+
+  /* Collect tiled clients in client list order */
+  for(i = 0; i < subtle->clients->ndata; i++)
+    {
+      SubClient *c = CLIENT(subtle->clients->data[i]);
+
+      if(c->screenid == screenid && VISIBLETAGS(c, v->tags) &&
+          !(c->flags & (SUB_CLIENT_DEAD|SUB_CLIENT_MODE_FLOAT|
+          SUB_CLIENT_MODE_FULL|SUB_CLIENT_TYPE_DESKTOP|SUB_CLIENT_TYPE_DOCK)))
+        clients[n++] = c;
+    }
+
+  /* Calculate all geometries in one pass and apply them in one go */
+  if(0 < n)
+    {
+      geoms = (XRectangle *)subSharedMemoryAlloc(n, sizeof(XRectangle));
+
+      layouts[v->layout].func(&(s->geom), geoms, n);
+
+      for(i = 0; i < n; i++)
+        subClientPlace(clients[i], &geoms[i], &(s->geom));
+
+      free(geoms);
+    }
+
+  free(clients);
+
+  subSubtleLogDebugSubtle("Apply: screen=%d, layout=%s, clients=%d\n",
+    screenid, layouts[v->layout].name, n);
+} /* }}} */
+
+/* Public */
+
+ /** subLayoutFind {{{
+  * @brief Find layout id by name
+  * @param[in]  name  Layout name
+  * @return Returns layout id or \p -1
+  **/
+
+int
+subLayoutFind(const char *name)
+{
+  int i;
+
+  assert(name);
+
+  for(i = 0; i < LENGTH(layouts); i++)
+    if(0 == strcmp(layouts[i].name, name)) return i;
+
+  return -1;
+} /* }}} */
+
+ /** subLayoutDirty {{{
+  * @brief Mark screen for a layout pass when its view has a layout
+  * @param[in]  screenid  Screen id
+  * @return Returns \p True when the view has a layout
+  **/
+
+int
+subLayoutDirty(int screenid)
+{
+  SubScreen *s = SCREEN(subArrayGet(subtle->screens, screenid));
+  SubView *v = NULL;
+
+  if(!s || !(v = VIEW(subArrayGet(subtle->views, s->viewid))) ||
+      -1 == v->layout)
+    return False;
+
+  s->flags |= SUB_SCREEN_LAYOUT;
+
+  return True;
+} /* }}} */
+
+ /** subLayoutFlush {{{
+  * @brief Apply layouts of all marked screens once
+  **/
+
+void
+subLayoutFlush(void)
+{
+  int i;
+
+  for(i = 0; i < subtle->screens->ndata; i++)
+    {
+      SubScreen *s = SCREEN(subtle->screens->data[i]);
+
+      if(s->flags & SUB_SCREEN_LAYOUT)
+        {
+          s->flags &= ~SUB_SCREEN_LAYOUT;
+
+          LayoutApply(i);
+        }
+    }
+} /* }}} */
+
+// vim:ts=2:bs=2:sw=2:et:fdm=marker
@@ -171,6 +171,7 @@ subPanelNew(int type)
         p->sublet->time    = subSubtleTime();
         p->sublet->text    = subTextNew();
         p->sublet->styleid = -1;
+        p->sublet->timer   = -1;
         break; /* }}} */
       case SUB_PANEL_VIEWS: /* {{{ */
         p->flags |= SUB_PANEL_DOWN;
@@ -480,30 +481,22 @@ subPanelRender(SubPanel *p,
   subSubtleLogDebugSubtle("Render\n");
 } /* }}} */
 
- /** subPanelCompare {{{
-  * @brief Compare two panels
-  * @param[in]  a  A #SubPanel
-  * @param[in]  b  A #SubPanel
-  * @return Returns the result of the comparison of both panels
-  * @retval  -1  a is smaller
-  * @retval  0   a and b are equal
-  * @retval  1   a is greater
+ /** subPanelDamage {{{
+  * @brief Mark panel content as changed for next render
+  * @param[in]  p  A #SubPanel
   **/
 
-int
-subPanelCompare(const void *a,
-  const void *b)
+void
+subPanelDamage(SubPanel *p)
 {
-  SubPanel *p1 = *(SubPanel **)a, *p2 = *(SubPanel **)b;
-
-  assert(a && b);
+  assert(p);
 
-  /* Include only interval sublets */
-  if(!(p1->sublet->flags & (SUB_SUBLET_INTERVAL))) return 1;
-  if(!(p2->sublet->flags & (SUB_SUBLET_INTERVAL))) return -1;
+  /* Sublets are shared between screens */
+  if(p->flags & SUB_PANEL_SUBLET)
+    p->sublet->flags |= SUB_SUBLET_DIRTY;
+  else p->flags |= SUB_PANEL_DIRTY;
 
-  return p1->sublet->time < p2->sublet->time ? -1 :
-    (p1->sublet->time == p2->sublet->time ? 0 : 1);
+  subScreenDirty(SUB_SUBTLE_DAMAGE);
 } /* }}} */
 
  /** subPanelAction {{{
@@ -567,8 +560,7 @@ subPanelAction(SubArray *panels,
                       break;
                   }
 
-                subScreenUpdate();
-                subScreenRender();
+                subPanelDamage(p);
                 break; /* }}} */
               case SUB_PANEL_VIEWS: /* {{{ */
                   {
@@ -683,8 +675,6 @@ subPanelPublish(void)
 
   subSubtleLogDebugSubtle("Publish: sublets=%d\n", subtle->sublets->ndata);
 
-  XSync(subtle->dpy, False); ///< Sync all changes
-
   free(sublets);
 } /* }}} */
 
@@ -723,14 +713,11 @@ subPanelKill(SubPanel *p)
               subRubyCall(SUB_CALL_UNLOAD, p->sublet->instance, NULL);
 
             subRubyRelease(p->sublet->instance);
+            subEventTimerDel(p);
 
             /* Remove socket watch */
             if(p->sublet->flags & SUB_SUBLET_SOCKET)
-              {
-                XDeleteContext(subtle->dpy, subtle->windows.support,
-                  p->sublet->watch);
-                subEventWatchDel(p->sublet->watch);
-              }
+              subEventWatchDel(p->sublet->watch);
 
 #ifdef HAVE_SYS_INOTIFY_H
             /* Remove inotify watch */
@@ -738,7 +725,7 @@ subPanelKill(SubPanel *p)
               {
                 XDeleteContext(subtle->dpy, subtle->windows.support,
                   p->sublet->watch);
-                inotify_rm_watch(subtle->notify, p->sublet->interval);
+                inotify_rm_watch(subtle->notify, p->sublet->watch);
               }
 #endif /* HAVE_SYS_INOTIFY_H */
 
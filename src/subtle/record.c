@@ -0,0 +1,851 @@
+
+ /**
+  * @package subtle
+  *
+  * @file Record functions
+  * @copyright (c) 2005-2013 Christoph Kappel <unexist@subforge.org>
+  * @version $Id$
+  *
+  * This program can be distributed under the terms of the GNU GPLv2.
+  * See the file COPYING for details.
+  **/
+
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <X11/Xatom.h>
+#include "subtle.h"
+
+#define MAGIC       "SUBREC2"                    ///< File magic and version
+#define RECORD_SELF (1L << 0)                    ///< Event caused by subtle
+
+#define NRECWINS  2                              ///< Windows per record
+#define NRECDATA  8                              ///< Values per record
+#define NRECPROPS 13                             ///< Recorded properties
+#define MAXRECLEN 65536                          ///< Max property length
+
+/* Window kinds {{{ */
+enum SubRecordKinds
+{
+  SUB_RECORD_NONE,                               ///< No window
+  SUB_RECORD_OWN,                                ///< Window of subtle
+  SUB_RECORD_CLIENT,                             ///< Client window
+  SUB_RECORD_TRAY,                               ///< Tray window
+  SUB_RECORD_OTHER                               ///< Unmanaged window
+}; /* }}} */
+
+/* Typedef {{{ */
+typedef struct subrecordhead_t
+{
+  char          magic[8];                        ///< Record magic
+  Window        root, support, tray;             ///< Record subtle windows
+  int           nscreens;                        ///< Record screens
+} SubRecordHead;
+
+typedef struct subrecordprop_t
+{
+  char          *name, *type;                    ///< Property name and type
+  int           format, nitems;                  ///< Property format and items
+  unsigned char *data;                           ///< Property data
+} SubRecordProp;
+
+typedef struct subrecord_t
+{
+  unsigned long time;                            ///< Record usec since start
+  int           type, flags;                     ///< Record event type and flags
+  Window        wins[NRECWINS];                  ///< Record referenced windows
+  char          kinds[NRECWINS];                 ///< Record window kinds
+  int           ndata, nprops;                   ///< Record values and properties
+  long          data[NRECDATA];                  ///< Record type values
+  char          *atom;                           ///< Record atom name
+  SubRecordProp props[NRECPROPS];                ///< Record property payloads
+} SubRecord;
+/* }}} */
+
+/* Globals */
+FILE *recfile = NULL;
+Display *recdpy = NULL;
+Window *recfrom = NULL, *recto = NULL;
+Atom recprops[NRECPROPS] = { None };
+SubRecord recnext;
+unsigned long recbegin = 0, recserial = 0, nrecords = 0;
+int nrecmap = 0, haverecnext = 0;
+
+/* RecordWriteString {{{ */
+static void
+RecordWriteString(char *str)
+{
+  int len = str ? strlen(str) : 0;
+
+  fwrite(&len, sizeof(int), 1, recfile);
+  fwrite(str, sizeof(char), len, recfile);
+} /* }}} */
+
+/* RecordReadString {{{ */
+static int
+RecordReadString(char **str)
+{
+  int len = 0;
+
+  *str = NULL;
+
+  if(1 != fread(&len, sizeof(int), 1, recfile) || 0 > len || 1024 < len)
+    return False;
+
+  if(0 < len)
+    {
+      *str = (char *)subSharedMemoryAlloc(len + 1, sizeof(char));
+
+      if(len != fread(*str, sizeof(char), len, recfile)) return False;
+    }
+
+  return True;
+} /* }}} */
+
+/* RecordKind {{{ */
+static char
+RecordKind(Window win)
+{
+  int i;
+
+  if(None == win) return SUB_RECORD_NONE;
+
+  /* Resolve window like subtle does */
+  if(ROOT == win || subtle->windows.support == win ||
+      subtle->windows.tray == win)
+    return SUB_RECORD_OWN;
+
+  for(i = 0; i < subtle->screens->ndata; i++)
+    {
+      SubScreen *s = SCREEN(subtle->screens->data[i]);
+
+      if(s->panel1 == win || s->panel2 == win) return SUB_RECORD_OWN;
+    }
+
+  if(subSubtleFind(win, CLIENTID)) return SUB_RECORD_CLIENT;
+  if(subSubtleFind(win, TRAYID))   return SUB_RECORD_TRAY;
+
+  return SUB_RECORD_OTHER;
+} /* }}} */
+
+/* RecordWriteProps {{{ */
+static void
+RecordWriteProps(Window win,
+  Atom only)
+{
+  int i, nprops = 0, formats[NRECPROPS] = { 0 };
+  unsigned long nitems[NRECPROPS] = { 0 }, bytes = 0;
+  unsigned char *data[NRECPROPS] = { NULL };
+  Atom atoms[NRECPROPS] = { None }, types[NRECPROPS] = { None };
+
+  /* Fetch payload of properties subtle reads */
+  for(i = 0; None != win && i < NRECPROPS; i++)
+    {
+      if(None != only && only != recprops[i]) continue;
+
+      if(Success == XGetWindowProperty(subtle->dpy, win, recprops[i], 0L,
+          MAXRECLEN / 4, False, AnyPropertyType, &types[nprops],
+          &formats[nprops], &nitems[nprops], &bytes, &data[nprops]))
+        {
+          if(None != types[nprops] && data[nprops])
+            atoms[nprops++] = recprops[i];
+          else if(data[nprops]) XFree(data[nprops]);
+        }
+    }
+
+  fwrite(&nprops, sizeof(int), 1, recfile);
+
+  for(i = 0; i < nprops; i++)
+    {
+      int n = nitems[i];
+      char *name = XGetAtomName(subtle->dpy, atoms[i]);
+      char *type = XGetAtomName(subtle->dpy, types[i]);
+
+      RecordWriteString(name);
+      RecordWriteString(type);
+      fwrite(&formats[i], sizeof(int), 1, recfile);
+      fwrite(&n,          sizeof(int), 1, recfile);
+
+      /* Xlib returns format 32 as longs */
+      fwrite(data[i], 32 == formats[i] ? sizeof(long) : formats[i] / 8,
+        n, recfile);
+
+      if(name) XFree(name);
+      if(type) XFree(type);
+      XFree(data[i]);
+    }
+} /* }}} */
+
+/* RecordWrite {{{ */
+static void
+RecordWrite(XEvent *ev,
+  int flags)
+{
+  int i, ndata = 0;
+  unsigned long time = subStatsTime() - recbegin;
+  long data[NRECDATA] = { 0 };
+  char kinds[NRECWINS] = { SUB_RECORD_NONE }, *name = NULL;
+  Window wins[NRECWINS] = { None }, props = None;
+  Atom atom = None, only = None;
+
+  /* Keep only fields replay needs */
+  switch(ev->type)
+    {
+      case MapRequest:
+        wins[0] = props = ev->xmaprequest.window;
+        break;
+      case ConfigureRequest:
+        wins[0]   = ev->xconfigurerequest.window;
+        wins[1]   = ev->xconfigurerequest.above;
+        data[0]   = ev->xconfigurerequest.value_mask;
+        data[1]   = ev->xconfigurerequest.x;
+        data[2]   = ev->xconfigurerequest.y;
+        data[3]   = ev->xconfigurerequest.width;
+        data[4]   = ev->xconfigurerequest.height;
+        data[5]   = ev->xconfigurerequest.border_width;
+        data[6]   = ev->xconfigurerequest.detail;
+        ndata     = 7;
+        break;
+      case UnmapNotify:
+        wins[0] = ev->xunmap.window;
+        break;
+      case DestroyNotify:
+        wins[0] = ev->xdestroywindow.window;
+        break;
+      case KeyPress:
+      case ButtonPress: ///< Same layout
+        wins[0] = ev->xkey.window;
+        wins[1] = ev->xkey.subwindow;
+        data[0] = ev->xkey.state;
+        data[1] = ev->xkey.keycode;
+        data[2] = ev->xkey.x;
+        data[3] = ev->xkey.y;
+        data[4] = ev->xkey.x_root;
+        data[5] = ev->xkey.y_root;
+        data[6] = ev->xkey.time;
+        ndata   = 7;
+        break;
+      case EnterNotify:
+      case LeaveNotify:
+        wins[0] = ev->xcrossing.window;
+        wins[1] = ev->xcrossing.subwindow;
+        data[0] = ev->xcrossing.x;
+        data[1] = ev->xcrossing.y;
+        data[2] = ev->xcrossing.x_root;
+        data[3] = ev->xcrossing.y_root;
+        data[4] = ev->xcrossing.mode;
+        data[5] = ev->xcrossing.detail;
+        data[6] = ev->xcrossing.focus;
+        data[7] = ev->xcrossing.state;
+        ndata   = 8;
+        break;
+      case FocusIn:
+        wins[0] = ev->xfocus.window;
+        data[0] = ev->xfocus.mode;
+        data[1] = ev->xfocus.detail;
+        ndata   = 2;
+        break;
+      case PropertyNotify:
+        wins[0] = ev->xproperty.window;
+        data[0] = ev->xproperty.state;
+        atom    = ev->xproperty.atom;
+        ndata   = 1;
+
+        /* Payload of new values only */
+        if(PropertyNewValue == ev->xproperty.state)
+          {
+            for(i = 0; i < NRECPROPS; i++)
+              if(recprops[i] == atom) props = wins[0];
+
+            only = atom;
+          }
+        break;
+      case ClientMessage:
+        wins[0] = ev->xclient.window;
+        atom    = ev->xclient.message_type;
+        data[0] = ev->xclient.format;
+        ndata   = 6;
+
+        for(i = 0; i < 5; i++)
+          data[i + 1] = ev->xclient.data.l[i];
+        break;
+
+      /* Everything else is caused by subtle and happens again */
+      default: return;
+    }
+
+  for(i = 0; i < NRECWINS; i++)
+    kinds[i] = RecordKind(wins[i]);
+
+  fwrite(&time,    sizeof(unsigned long), 1,        recfile);
+  fwrite(&ev->type, sizeof(int),          1,        recfile);
+  fwrite(&flags,   sizeof(int),           1,        recfile);
+  fwrite(wins,     sizeof(Window),        NRECWINS, recfile);
+  fwrite(kinds,    sizeof(char),          NRECWINS, recfile);
+  fwrite(&ndata,   sizeof(int),           1,        recfile);
+  fwrite(data,     sizeof(long),          ndata,    recfile);
+
+  /* Atom ids differ between servers */
+  if(None != atom) name = XGetAtomName(subtle->dpy, atom);
+  RecordWriteString(name);
+  if(name) XFree(name);
+
+  RecordWriteProps(props, only);
+
+  nrecords++;
+} /* }}} */
+
+/* RecordClear {{{ */
+static void
+RecordClear(SubRecord *r)
+{
+  int i;
+
+  for(i = 0; i < r->nprops; i++)
+    {
+      if(r->props[i].name) free(r->props[i].name);
+      if(r->props[i].type) free(r->props[i].type);
+      if(r->props[i].data) free(r->props[i].data);
+    }
+
+  if(r->atom) free(r->atom);
+
+  memset(r, 0, sizeof(SubRecord));
+} /* }}} */
+
+/* RecordRead {{{ */
+static int
+RecordRead(SubRecord *r)
+{
+  int i;
+
+  RecordClear(r);
+
+  if(1 != fread(&r->time,  sizeof(unsigned long), 1, recfile) ||
+      1 != fread(&r->type,  sizeof(int),          1, recfile) ||
+      1 != fread(&r->flags, sizeof(int),          1, recfile) ||
+      NRECWINS != fread(r->wins,  sizeof(Window), NRECWINS, recfile) ||
+      NRECWINS != fread(r->kinds, sizeof(char),   NRECWINS, recfile) ||
+      1 != fread(&r->ndata, sizeof(int),          1, recfile) ||
+      0 > r->ndata || NRECDATA < r->ndata ||
+      r->ndata != fread(r->data, sizeof(long), r->ndata, recfile) ||
+      !RecordReadString(&r->atom) ||
+      1 != fread(&r->nprops, sizeof(int), 1, recfile) ||
+      0 > r->nprops || NRECPROPS < r->nprops)
+    {
+      r->nprops = 0;
+
+      return False;
+    }
+
+  for(i = 0; i < r->nprops; i++)
+    {
+      SubRecordProp *p = &r->props[i];
+      size_t size = 0;
+
+      if(!RecordReadString(&p->name) || !RecordReadString(&p->type) ||
+          1 != fread(&p->format, sizeof(int), 1, recfile) ||
+          1 != fread(&p->nitems, sizeof(int), 1, recfile) ||
+          (8 != p->format && 16 != p->format && 32 != p->format) ||
+          0 > p->nitems || MAXRECLEN < p->nitems)
+        {
+          r->nprops = i + 1;
+
+          return False;
+        }
+
+      size    = 32 == p->format ? sizeof(long) : p->format / 8;
+      p->data = (unsigned char *)subSharedMemoryAlloc(p->nitems + 1, size);
+
+      if(p->nitems != fread(p->data, size, p->nitems, recfile))
+        {
+          r->nprops = i + 1;
+
+          return False;
+        }
+    }
+
+  return True;
+} /* }}} */
+
+/* RecordMapAdd {{{ */
+static void
+RecordMapAdd(Window old,
+  Window win)
+{
+  if(None != old)
+    {
+      recfrom = (Window *)subSharedMemoryRealloc(recfrom, (nrecmap + 1) * sizeof(Window));
+      recto   = (Window *)subSharedMemoryRealloc(recto,   (nrecmap + 1) * sizeof(Window));
+
+      recfrom[nrecmap] = old;
+      recto[nrecmap]   = win;
+      nrecmap++;
+    }
+} /* }}} */
+
+/* RecordMapDel {{{ */
+static void
+RecordMapDel(Window old)
+{
+  int i;
+
+  for(i = 0; i < nrecmap; i++)
+    {
+      if(recfrom[i] == old)
+        {
+          /* Fill gap with last entry */
+          nrecmap--;
+          recfrom[i] = recfrom[nrecmap];
+          recto[i]   = recto[nrecmap];
+
+          break;
+        }
+    }
+} /* }}} */
+
+/* RecordMap {{{ */
+static Window
+RecordMap(Window old,
+  int create)
+{
+  int i;
+  Window win = None;
+  char buf[32] = { 0 };
+
+  if(None == old) return None;
+
+  /* Find mapped window */
+  for(i = 0; i < nrecmap; i++)
+    if(recfrom[i] == old) return recto[i];
+
+  /* Create stand-in client window */
+  if(create)
+    {
+      win = XCreateSimpleWindow(recdpy, DefaultRootWindow(recdpy),
+        0, 0, 100, 100, 0, BlackPixel(recdpy, DefaultScreen(recdpy)),
+        WhitePixel(recdpy, DefaultScreen(recdpy)));
+
+      snprintf(buf, sizeof(buf), "replay:%#lx", old);
+      XStoreName(recdpy, win, buf);
+      XSync(recdpy, False); ///< Window must exist before use
+
+      RecordMapAdd(old, win);
+
+      subSubtleLogDebugSubtle("Map: old=%#lx, win=%#lx\n", old, win);
+    }
+
+  return win;
+} /* }}} */
+
+/* RecordFinish {{{ */
+static void
+RecordFinish(void)
+{
+  struct rusage usage;
+  unsigned long elapsed = subStatsTime() - recbegin;
+
+  getrusage(RUSAGE_SELF, &usage);
+
+  printf("Replay: records=%lu, time=%lums, cpu=%ldms, requests=%lu\n",
+    nrecords, elapsed / 1000,
+    (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000 +
+    (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000,
+    NextRequest(subtle->dpy) - recserial);
+
+  subStatsPublish(True);
+
+  subtle->flags &= ~SUB_SUBTLE_RUN;
+} /* }}} */
+
+/* RecordProps {{{ */
+static void
+RecordProps(SubRecord *r,
+  Window win)
+{
+  int i, j;
+
+  /* Set recorded payloads on stand-in */
+  for(i = 0; i < r->nprops; i++)
+    {
+      SubRecordProp *p = &r->props[i];
+      Atom type = XInternAtom(recdpy, p->type, False);
+
+      /* Map windows to stand-ins */
+      if(XA_WINDOW == type && 32 == p->format)
+        for(j = 0; j < p->nitems; j++)
+          ((long *)p->data)[j] = RecordMap(((long *)p->data)[j], False);
+
+      XChangeProperty(recdpy, win, XInternAtom(recdpy, p->name, False),
+        type, p->format, PropModeReplace, p->data, p->nitems);
+    }
+} /* }}} */
+
+/* RecordReplay {{{ */
+static void
+RecordReplay(SubRecord *r)
+{
+  int create = False;
+  Window win = None, other = None;
+  XEvent ev;
+
+  /* Never create stand-ins for windows of subtle */
+  create = (SUB_RECORD_OWN != r->kinds[0]);
+
+  memset(&ev, 0, sizeof(XEvent));
+
+  ev.type         = r->type;
+  ev.xany.display = subtle->dpy;
+  ev.xany.window  = win = RecordMap(r->wins[0], False);
+  other           = RecordMap(r->wins[1], False);
+
+  switch(r->type)
+    {
+      /* Client actions: Let the server generate the real events */
+      case MapRequest:
+        if(create && None != (win = RecordMap(r->wins[0], True)))
+          {
+            RecordProps(r, win);
+            XMapWindow(recdpy, win);
+          }
+        break;
+      case ConfigureRequest:
+        if(create && 7 == r->ndata &&
+            None != (win = RecordMap(r->wins[0], True)))
+          {
+            XWindowChanges wc;
+            unsigned int mask = r->data[0];
+
+            wc.x            = r->data[1];
+            wc.y            = r->data[2];
+            wc.width        = r->data[3];
+            wc.height       = r->data[4];
+            wc.border_width = r->data[5];
+            wc.stack_mode   = r->data[6];
+            wc.sibling      = other;
+
+            /* Skip sibling when we don't know it */
+            if(None == wc.sibling) mask &= ~CWSibling;
+
+            XConfigureWindow(recdpy, win, mask, &wc);
+          }
+        break;
+      case UnmapNotify:
+        if(!(r->flags & RECORD_SELF) && None != win)
+          XUnmapWindow(recdpy, win);
+        break;
+      case DestroyNotify:
+        if(None != win)
+          {
+            XDestroyWindow(recdpy, win);
+            RecordMapDel(r->wins[0]);
+          }
+        break;
+      case PropertyNotify:
+        if(None != win && 1 == r->ndata && r->atom)
+          {
+            /* Change property, the server notifies subtle */
+            if(0 < r->nprops) RecordProps(r, win);
+            else if(PropertyDelete == r->data[0])
+              XDeleteProperty(recdpy, win, XInternAtom(recdpy, r->atom, False));
+            else
+              {
+                ev.xproperty.atom  = XInternAtom(subtle->dpy, r->atom, False);
+                ev.xproperty.state = r->data[0];
+
+                subEventDispatch(&ev);
+              }
+          }
+        break;
+
+      /* Presses: Send through the server to queue behind client requests */
+      case KeyPress:
+      case ButtonPress: ///< Same layout
+        if(7 == r->ndata)
+          {
+            ev.xkey.root      = ROOT;
+            ev.xkey.subwindow = other;
+            ev.xkey.state     = r->data[0];
+            ev.xkey.keycode   = r->data[1];
+            ev.xkey.x         = r->data[2];
+            ev.xkey.y         = r->data[3];
+            ev.xkey.x_root    = r->data[4];
+            ev.xkey.y_root    = r->data[5];
+            ev.xkey.time      = r->data[6];
+
+            XSendEvent(recdpy, subtle->windows.support, False,
+              NoEventMask, &ev);
+          }
+        break;
+
+      /* Crossings and messages: Dispatch directly */
+      case EnterNotify:
+      case LeaveNotify:
+        if(8 == r->ndata)
+          {
+            ev.xcrossing.root      = ROOT;
+            ev.xcrossing.subwindow = other;
+            ev.xcrossing.x         = r->data[0];
+            ev.xcrossing.y         = r->data[1];
+            ev.xcrossing.x_root    = r->data[2];
+            ev.xcrossing.y_root    = r->data[3];
+            ev.xcrossing.mode      = r->data[4];
+            ev.xcrossing.detail    = r->data[5];
+            ev.xcrossing.focus     = r->data[6];
+            ev.xcrossing.state     = r->data[7];
+
+            subEventDispatch(&ev);
+          }
+        break;
+      case FocusIn:
+        if(None != win && 2 == r->ndata)
+          {
+            ev.xfocus.mode   = r->data[0];
+            ev.xfocus.detail = r->data[1];
+
+            subEventDispatch(&ev);
+          }
+        break;
+      case ClientMessage:
+        if(None != win && 6 == r->ndata && r->atom)
+          {
+            int i;
+
+            ev.xclient.message_type = XInternAtom(subtle->dpy, r->atom, False);
+            ev.xclient.format       = r->data[0];
+
+            for(i = 0; i < 5; i++)
+              ev.xclient.data.l[i] = r->data[i + 1];
+
+            subEventDispatch(&ev);
+          }
+        break;
+      default: break;
+    }
+
+  XFlush(recdpy);
+} /* }}} */
+
+/* Public */
+
+ /** subRecordInit {{{
+  * @brief Open record file and start recording or replaying
+  **/
+
+void
+subRecordInit(void)
+{
+  int i;
+  SubRecordHead head;
+
+  recbegin  = subStatsTime();
+  recserial = NextRequest(subtle->dpy);
+
+  /* Properties subtle reads when it manages or updates clients */
+  recprops[0]  = XA_WM_CLASS;
+  recprops[1]  = XA_WM_NAME;
+  recprops[2]  = subEwmhGet(SUB_EWMH_NET_WM_NAME);
+  recprops[3]  = subEwmhGet(SUB_EWMH_WM_WINDOW_ROLE);
+  recprops[4]  = XA_WM_HINTS;
+  recprops[5]  = XA_WM_NORMAL_HINTS;
+  recprops[6]  = XA_WM_TRANSIENT_FOR;
+  recprops[7]  = subEwmhGet(SUB_EWMH_WM_PROTOCOLS);
+  recprops[8]  = subEwmhGet(SUB_EWMH_WM_CLIENT_LEADER);
+  recprops[9]  = subEwmhGet(SUB_EWMH_NET_WM_WINDOW_TYPE);
+  recprops[10] = subEwmhGet(SUB_EWMH_NET_WM_STATE);
+  recprops[11] = subEwmhGet(SUB_EWMH_NET_WM_STRUT);
+  recprops[12] = subEwmhGet(SUB_EWMH_MOTIF_WM_HINTS);
+
+  /* Record mode {{{ */
+  if(subtle->flags & SUB_SUBTLE_RECORD)
+    {
+      if(!(recfile = fopen(subtle->paths.record, "wb")))
+        {
+          subSubtleLogError("Cannot open record file `%s'\n",
+            subtle->paths.record);
+          subtle->flags &= ~SUB_SUBTLE_RECORD;
+
+          return;
+        }
+
+      /* Write header and subtle windows */
+      memset(&head, 0, sizeof(SubRecordHead));
+      strncpy(head.magic, MAGIC, sizeof(head.magic));
+
+      head.root     = ROOT;
+      head.support  = subtle->windows.support;
+      head.tray     = subtle->windows.tray;
+      head.nscreens = subtle->screens->ndata;
+
+      fwrite(&head, sizeof(SubRecordHead), 1, recfile);
+
+      for(i = 0; i < subtle->screens->ndata; i++)
+        {
+          SubScreen *s = SCREEN(subtle->screens->data[i]);
+
+          fwrite(&s->panel1, sizeof(Window), 1, recfile);
+          fwrite(&s->panel2, sizeof(Window), 1, recfile);
+        }
+
+      /* Fake map requests for already managed clients */
+      for(i = 0; i < subtle->clients->ndata; i++)
+        {
+          XEvent ev;
+
+          memset(&ev, 0, sizeof(XEvent));
+
+          ev.type                = MapRequest;
+          ev.xmaprequest.parent  = ROOT;
+          ev.xmaprequest.window  = CLIENT(subtle->clients->data[i])->win;
+
+          RecordWrite(&ev, 0);
+        }
+
+      subSubtleLogDebugSubtle("Record: file=%s\n", subtle->paths.record);
+    } /* }}} */
+  /* Replay mode {{{ */
+  else if(subtle->flags & SUB_SUBTLE_REPLAY)
+    {
+      if(!(recfile = fopen(subtle->paths.record, "rb")) ||
+          1 != fread(&head, sizeof(SubRecordHead), 1, recfile) ||
+          strncmp(head.magic, MAGIC, sizeof(head.magic)))
+        {
+          subSubtleLogError("Cannot read record file `%s'\n",
+            subtle->paths.record);
+          subtle->flags &= ~SUB_SUBTLE_REPLAY;
+
+          return;
+        }
+
+      /* Open connection for stand-in clients */
+      if(!(recdpy = XOpenDisplay(DisplayString(subtle->dpy))))
+        {
+          subSubtleLogError("Cannot open client display\n");
+          subtle->flags &= ~SUB_SUBTLE_REPLAY;
+
+          return;
+        }
+
+      /* Map subtle windows */
+      RecordMapAdd(head.root,    ROOT);
+      RecordMapAdd(head.support, subtle->windows.support);
+      RecordMapAdd(head.tray,    subtle->windows.tray);
+
+      for(i = 0; i < head.nscreens; i++)
+        {
+          Window panels[2] = { None };
+          SubScreen *s = SCREEN(subArrayGet(subtle->screens, i));
+
+          if(2 != fread(panels, sizeof(Window), 2, recfile)) break;
+
+          if(s)
+            {
+              RecordMapAdd(panels[0], s->panel1);
+              RecordMapAdd(panels[1], s->panel2);
+            }
+        }
+
+      subSubtleLogDebugSubtle("Replay: file=%s\n", subtle->paths.record);
+    } /* }}} */
+} /* }}} */
+
+ /** subRecordEvent {{{
+  * @brief Record event before it is handled
+  * @param[in]  ev  A #XEvent
+  **/
+
+void
+subRecordEvent(XEvent *ev)
+{
+  int flags = 0;
+
+  assert(ev);
+
+  if(!recfile) return;
+
+  /* Mark unmaps subtle caused itself, a replay causes them again */
+  if(UnmapNotify == ev->type)
+    {
+      SubClient *c = NULL;
+      SubTray *t = NULL;
+
+      if(((c = CLIENT(subSubtleFind(ev->xunmap.window, CLIENTID))) &&
+          c->flags & SUB_CLIENT_UNMAP) ||
+          ((t = TRAY(subSubtleFind(ev->xunmap.window, TRAYID))) &&
+          t->flags & SUB_TRAY_UNMAP))
+        flags |= RECORD_SELF;
+    }
+
+  RecordWrite(ev, flags);
+} /* }}} */
+
+ /** subRecordReplay {{{
+  * @brief Replay all due records
+  * @return Returns ms until next record or \p -1 when done
+  **/
+
+int
+subRecordReplay(void)
+{
+  unsigned long now = 0;
+
+  if(!recfile) return -1;
+
+  now = subStatsTime() - recbegin;
+
+  /* Replay with recorded pace */
+  while(True)
+    {
+      if(!haverecnext)
+        {
+          if(!RecordRead(&recnext))
+            {
+              RecordFinish();
+
+              return -1;
+            }
+
+          haverecnext = True;
+        }
+
+      if(recnext.time > now) break;
+
+      haverecnext = False;
+      nrecords++;
+
+      RecordReplay(&recnext);
+    }
+
+  return (recnext.time - now) / 1000;
+} /* }}} */
+
+ /** subRecordFinish {{{
+  * @brief Close record file
+  **/
+
+void
+subRecordFinish(void)
+{
+  if(recfile)
+    {
+      fclose(recfile);
+      recfile = NULL;
+    }
+
+  if(recdpy)
+    {
+      XCloseDisplay(recdpy);
+      recdpy = NULL;
+    }
+
+  if(recfrom) free(recfrom);
+  if(recto)   free(recto);
+
+  RecordClear(&recnext);
+
+  recfrom = recto = NULL;
+  nrecmap = 0;
+
+  subSubtleLogDebugSubtle("Finish\n");
+} /* }}} */
+
+// vim:ts=2:bs=2:sw=2:et:fdm=marker
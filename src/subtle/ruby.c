@@ -22,6 +22,12 @@
 #include <X11/Xresource.h>
 #include "subtle.h"
 
+#if defined HAVE_RB_POSTPONED_JOB_PREREGISTER || \
+  defined HAVE_RB_POSTPONED_JOB_REGISTER_ONE
+#define RUBY_STALL_BACKTRACE
+#include <ruby/debug.h>
+#endif /* HAVE_RB_POSTPONED_JOB_PREREGISTER || .. */
+
 #ifdef HAVE_WORDEXP_H
   #include <wordexp.h>
 #endif /* HAVE_WORDEXP_H */
@@ -34,6 +40,11 @@
 /* Globals {{{ */
 static VALUE shelter = Qnil, mod = Qnil, config_sublets = Qnil;
 static VALUE config_instance = Qnil, config_methods = Qnil;
+static unsigned long synced = 0;
+
+#ifdef HAVE_RB_POSTPONED_JOB_PREREGISTER
+static rb_postponed_job_handle_t stalljob = POSTPONED_JOB_HANDLE_INVALID;
+#endif /* HAVE_RB_POSTPONED_JOB_PREREGISTER */
 /* }}} */
 
 /* Typedef {{{ */
@@ -74,6 +85,23 @@ RubyBacktrace(void)
     }
 } /* }}} */
 
+#ifdef RUBY_STALL_BACKTRACE
+/* RubyStallBacktrace {{{ */
+static void
+RubyStallBacktrace(void *data)
+{
+  int i;
+  VALUE backtrace = Qnil, entry = Qnil;
+
+  /* Print where the stalled call currently is */
+  backtrace = rb_make_backtrace();
+
+  subSubtleLogWarn("Stall: Ruby backtrace\n");
+  for(i = 0; Qnil != (entry = rb_ary_entry(backtrace, i)); ++i)
+    printf("\tfrom %s\n", RSTRING_PTR(entry));
+} /* }}} */
+#endif /* RUBY_STALL_BACKTRACE */
+
 /* RubyFilter {{{ */
 static inline int
 #ifdef IS_OPENBSD
@@ -139,8 +167,6 @@ RubySubtleToSubtlext(void *data)
       int id = 0;
       VALUE subtlext = Qnil, klass = Qnil;
 
-      XSync(subtle->dpy, False); ///< Sync before going on
-
       subtlext = rb_const_get(rb_mKernel, rb_intern("Subtlext"));
 
       if(c->flags & SUB_TYPE_CLIENT) /* {{{ */
@@ -455,6 +481,21 @@ RubyValueToHash(VALUE value)
   return hash;
 } /* }}} */
 
+/* RubyValueToInterval {{{ */
+static time_t
+RubyValueToInterval(VALUE value)
+{
+  time_t ms = 0;
+
+  /* Convert seconds to milliseconds */
+  if(FIXNUM_P(value))
+    ms = (time_t)FIX2LONG(value) * 1000;
+  else if(T_FLOAT == rb_type(value))
+    ms = (time_t)(NUM2DBL(value) * 1000.0 + 0.5);
+
+  return ms;
+} /* }}} */
+
 /* RubyHashToColor {{{ */
 static void
 RubyHashToColor(VALUE hash,
@@ -726,6 +767,11 @@ RubyEvalGrab(VALUE keys,
                 type = SUB_GRAB_WINDOW_SELECT;
                 data = DATA((unsigned long)SUB_GRAB_DIRECTION_RIGHT);
               }
+            else if(CHAR2SYM("WindowRecent") == value)
+              {
+                type = SUB_GRAB_WINDOW_SELECT;
+                data = DATA((unsigned long)SUB_GRAB_DIRECTION_RECENT);
+              }
             else if(CHAR2SYM("WindowKill") == value)
               {
                 type = SUB_GRAB_WINDOW_KILL;
@@ -1469,9 +1515,6 @@ RubyWrapLoadPanels(VALUE data)
           if(p->flags & SUB_PANEL_SUBLET && !p->screen)
             subRubyUnloadSublet(p);
         }
-
-      /* Finally sort sublets */
-      subArraySort(subtle->sublets, subPanelCompare);
     }
 
   return Qnil;
@@ -1556,8 +1599,7 @@ RubyWrapCall(VALUE data)
             rb_funcall(rargs[1], rb_intern("call"), arity, receiver,
               RubySubtleToSubtlext((VALUE *)rargs[2]));
 
-            subScreenUpdate();
-            subScreenRender();
+            subScreenDirty(SUB_SUBTLE_UPDATE);
           }
         else
           {
@@ -1611,8 +1653,9 @@ RubyWrapSubletConfig(VALUE data)
       VALUE value = Qnil;
 
       /* Set sublet interval */
-      if(FIXNUM_P(value = rb_hash_lookup(hash, CHAR2SYM("interval"))))
-        s->interval = FIX2INT(value);
+      value = rb_hash_lookup(hash, CHAR2SYM("interval"));
+      if(FIXNUM_P(value) || T_FLOAT == rb_type(value))
+        s->interval = RubyValueToInterval(value);
 
       /* Set sublet style */
       if(T_SYMBOL == rb_type(value = rb_hash_lookup(hash,
@@ -1945,6 +1988,16 @@ RubyConfigSet(VALUE self,
                 if(!(subtle->flags & SUB_SUBTLE_CHECK))
                   subtle->gravity = value; ///< Store for later
               }
+            else if(CHAR2SYM("queue_expiry") == option)
+              {
+                if(!(subtle->flags & SUB_SUBTLE_CHECK))
+                  subtle->expiry = MAX(0, FIX2INT(value)) * 1000;
+              }
+            else if(CHAR2SYM("stall_budget") == option)
+              {
+                if(!(subtle->flags & SUB_SUBTLE_CHECK))
+                  subtle->budget = MAX(0, FIX2INT(value));
+              }
             else subSubtleLogWarn("Unknown option `:%s'\n", SYM2CHAR(option));
             break; /* }}} */
           case T_SYMBOL: /* {{{ */
@@ -1976,6 +2029,11 @@ RubyConfigSet(VALUE self,
                 if(!(subtle->flags & SUB_SUBTLE_CHECK) && Qtrue == value)
                   subtle->flags |= SUB_SUBTLE_TILING;
               }
+            else if(CHAR2SYM("opaque_drag") == option)
+              {
+                if(!(subtle->flags & SUB_SUBTLE_CHECK) && Qtrue == value)
+                  subtle->flags |= SUB_SUBTLE_OPAQUE;
+              }
             else if(CHAR2SYM("click_to_focus") == option)
               {
                 if(!(subtle->flags & SUB_SUBTLE_CHECK) && Qtrue == value)
@@ -1991,6 +2049,11 @@ RubyConfigSet(VALUE self,
                 if(!(subtle->flags & SUB_SUBTLE_CHECK) && Qtrue == value)
                   subtle->flags |= SUB_SUBTLE_SKIP_URGENT_WARP;
               }
+            else if(CHAR2SYM("spread_sublets") == option)
+              {
+                if(!(subtle->flags & SUB_SUBTLE_CHECK) && Qtrue == value)
+                  subtle->flags |= SUB_SUBTLE_SPREAD;
+              }
             else subSubtleLogWarn("Unknown option `:%s'\n", SYM2CHAR(option));
             break; /* }}} */
           case T_STRING: /* {{{ */
@@ -2288,7 +2351,7 @@ RubyConfigView(int argc,
   VALUE *argv,
   VALUE self)
 {
-  int flags = 0;
+  int flags = 0, layout = -1;
   VALUE name = Qnil, match = Qnil, params = Qnil, value = Qnil, icon = value;
 
   rb_scan_args(argc, argv, "11", &name, &match);
@@ -2319,6 +2382,12 @@ RubyConfigView(int argc,
           CHAR2SYM("icon_only"))))
         flags |= SUB_VIEW_ICON_ONLY;
 
+      /* Check layout */
+      if(T_SYMBOL == rb_type(value = rb_hash_lookup(params,
+          CHAR2SYM("layout"))) &&
+          -1 == (layout = subLayoutFind(SYM2CHAR(value))))
+        subSubtleLogWarn("Cannot find layout `%s'\n", SYM2CHAR(value));
+
       /* Check icon */
       icon = RubyValueToIcon(rb_hash_lookup(params, CHAR2SYM("icon")));
     }
@@ -2345,7 +2414,8 @@ RubyConfigView(int argc,
           /* Finally create new view */
           if((v = subViewNew(RSTRING_PTR(name), re)))
             {
-              v->flags |= flags;
+              v->flags  |= flags;
+              v->layout  = layout;
 
               subArrayPush(subtle->views, (void *)v);
 
@@ -2954,7 +3024,7 @@ RubySubletRender(VALUE self)
   SubPanel *p = NULL;
 
   Data_Get_Struct(self, SubPanel, p);
-  if(p) subScreenRender();
+  if(p) subPanelDamage(p);
 
   return Qnil;
 } /* }}} */
@@ -2981,32 +3051,48 @@ RubySubletNameReader(VALUE self)
 
 /* RubySubletIntervalReader {{{ */
 /*
- * call-seq: interval -> Fixnum
+ * call-seq: interval -> Fixnum or Float
  *
- * Get interval time of Sublet
+ * Get interval time of Sublet in seconds
  *
  *  puts sublet.interval
  *  => 60
+ *
+ *  puts sublet.interval
+ *  => 0.25
  */
 
 static VALUE
 RubySubletIntervalReader(VALUE self)
 {
+  VALUE ret = Qnil;
   SubPanel *p = NULL;
 
   Data_Get_Struct(self, SubPanel, p);
+  if(p)
+    {
+      /* Keep whole seconds as fixnum */
+      if(0 == p->sublet->interval % 1000)
+        ret = INT2FIX(p->sublet->interval / 1000);
+      else ret = rb_float_new(p->sublet->interval / 1000.0);
+    }
 
-  return p ? INT2FIX(p->sublet->interval) : Qnil;
+  return ret;
 } /* }}} */
 
 /* RubySubletIntervalWriter {{{ */
 /*
  * call-seq: interval=(fixnum) -> nil
+ *           interval=(float)  -> nil
  *
- * Set interval time of Sublet
+ * Set interval time of Sublet in seconds, floats allow
+ * millisecond resolution
  *
  *  sublet.interval = 60
  *  => nil
+ *
+ *  sublet.interval = 0.25
+ *  => nil
  */
 
 static VALUE
@@ -3018,14 +3104,20 @@ RubySubletIntervalWriter(VALUE self,
   Data_Get_Struct(self, SubPanel, p);
   if(p)
     {
-      if(FIXNUM_P(value))
+      if(FIXNUM_P(value) || T_FLOAT == rb_type(value))
         {
-          p->sublet->interval = FIX2INT(value);
-          p->sublet->time     = subSubtleTime() + p->sublet->interval;
+          p->sublet->interval = RubyValueToInterval(value);
 
           if(0 < p->sublet->interval)
-            p->sublet->flags |= SUB_SUBLET_INTERVAL;
-          else p->sublet->flags &= ~SUB_SUBLET_INTERVAL;
+            {
+              p->sublet->flags |= SUB_SUBLET_INTERVAL;
+              subEventTimerAdd(p);
+            }
+          else
+            {
+              p->sublet->flags &= ~SUB_SUBLET_INTERVAL;
+              subEventTimerDel(p);
+            }
         }
       else rb_raise(rb_eArgError, "Unknown value type `%s'", rb_obj_classname(value));
     }
@@ -3100,6 +3192,7 @@ RubySubletDataWriter(VALUE self,
           p->sublet->width = subTextParse(p->sublet->text,
             subtle->styles.sublets.font, RSTRING_PTR(value)) +
             STYLE_WIDTH((*s));
+          p->sublet->flags |= SUB_SUBLET_DIRTY;
         }
       else rb_raise(rb_eArgError, "Unknown value type");
     }
@@ -3204,6 +3297,7 @@ RubySubletStyleWriter(VALUE self,
           p->sublet->width = subTextParse(p->sublet->text,
             subtle->styles.sublets.font, RSTRING_PTR(value)) +
             STYLE_WIDTH((*s));
+          p->sublet->flags |= SUB_SUBLET_DIRTY;
         }
       else rb_raise(rb_eArgError, "Unknown value type");
     }
@@ -3232,8 +3326,7 @@ RubySubletShow(VALUE self)
       p->flags &= ~SUB_PANEL_HIDDEN;
 
       /* Update screens */
-      subScreenUpdate();
-      subScreenRender();
+      subScreenDirty(SUB_SUBTLE_UPDATE);
     }
 
   return Qnil;
@@ -3261,8 +3354,7 @@ RubySubletHide(VALUE self,
       p->flags |= SUB_PANEL_HIDDEN;
 
       /* Update screens */
-      subScreenUpdate();
-      subScreenRender();
+      subScreenDirty(SUB_SUBTLE_UPDATE);
     }
 
   return Qnil;
@@ -3309,9 +3401,7 @@ RubySubletWatch(VALUE self,
                     0, NULL));
                 }
 
-              XSaveContext(subtle->dpy, subtle->windows.support,
-                p->sublet->watch, (void *)p);
-              subEventWatchAdd(p->sublet->watch);
+              subEventWatchAdd(p->sublet->watch, (void *)p);
 
               /* Set nonblocking */
               if(-1 == (flags = fcntl(p->sublet->watch, F_GETFL, 0))) flags = 0;
@@ -3384,7 +3474,6 @@ RubySubletUnwatch(VALUE self)
       /* Probably a socket */
       if(p->sublet->flags & SUB_SUBLET_SOCKET)
         {
-          XDeleteContext(subtle->dpy, subtle->windows.support, p->sublet->watch);
           subEventWatchDel(p->sublet->watch);
 
           p->sublet->flags &= ~SUB_SUBLET_SOCKET;
@@ -3435,6 +3524,33 @@ RubySubletWarn(VALUE self,
   return Qnil;
 } /* }}} */
 
+/* Subtle */
+
+/* RubySubtleSync {{{ */
+/*
+ * call-seq: sync -> nil
+ *
+ * Let the server process pending requests of subtle, subtlext calls
+ * this before it uses its own connection
+ *
+ *  Subtle.sync
+ *  => nil
+ */
+
+static VALUE
+RubySubtleSync(VALUE self)
+{
+  /* Only sync when new requests were sent since last sync */
+  if(subtle->dpy && NextRequest(subtle->dpy) - 1 != synced)
+    {
+      XSync(subtle->dpy, False);
+
+      synced = NextRequest(subtle->dpy) - 1;
+    }
+
+  return Qnil;
+} /* }}} */
+
 /* Public */
 
  /** subRubyInit {{{
@@ -3451,6 +3567,11 @@ subRubyInit(void)
   ruby_init_loadpath();
   ruby_script("subtle");
 
+#ifdef HAVE_RB_POSTPONED_JOB_PREREGISTER
+  /* Register job for stall backtraces once */
+  stalljob = rb_postponed_job_preregister(0, RubyStallBacktrace, NULL);
+#endif /* HAVE_RB_POSTPONED_JOB_PREREGISTER */
+
 #ifdef HAVE_RB_ENC_SET_DEFAULT_INTERNAL
   {
     VALUE encoding = Qnil;
@@ -3491,6 +3612,9 @@ subRubyInit(void)
 
   mod = rb_define_module("Subtle");
 
+  /* Module methods */
+  rb_define_module_function(mod, "sync", RubySubtleSync, 0);
+
   /*
    * Document-class: Config
    *
@@ -3797,7 +3921,7 @@ subRubyLoadSublet(const char *file)
     }
 
   /* Sanitize interval time */
-  if(0 >= p->sublet->interval) p->sublet->interval = 60;
+  if(0 >= p->sublet->interval) p->sublet->interval = 60000;
 
   /* First run */
   if(p->sublet->flags & SUB_SUBLET_RUN)
@@ -3961,6 +4085,8 @@ subRubyCall(int type,
   void *data)
 {
   int state = 0;
+  unsigned long start = subStatsTime();
+  const char *name = NULL;
   VALUE rargs[3] = { Qnil };
 
   /* Wrap up data */
@@ -3968,10 +4094,32 @@ subRubyCall(int type,
   rargs[1] = proc;
   rargs[2] = (VALUE)data;
 
+  /* Name sublet for stall watchdog */
+  if(!(type & SUB_CALL_HOOKS) && T_DATA == rb_type(proc))
+    {
+      SubPanel *p = NULL;
+
+      Data_Get_Struct(proc, SubPanel, p);
+      if(p && p->flags & SUB_PANEL_SUBLET) name = p->sublet->name;
+    }
+
+  subStatsStallEnter(type, True, name);
+
   /* Carefully call */
   rb_protect(RubyWrapCall, (VALUE)&rargs, &state);
   if(state) RubyBacktrace();
 
+  /* Name stalled hook by its source location */
+  if(subStatsStallLeave() && type & SUB_CALL_HOOKS)
+    {
+      VALUE str = rb_protect(rb_inspect, proc, NULL);
+
+      if(T_STRING == rb_type(str))
+        subSubtleLogWarn("Stall: Hook %s\n", RSTRING_PTR(str));
+    }
+
+  subStatsCall(type, start);
+
 #ifdef DEBUG
   subSubtleLogDebugRuby("Call: GC START\n");
   rb_gc_start();
@@ -3980,6 +4128,21 @@ subRubyCall(int type,
   return !state; ///< Reverse odd logic
 } /* }}} */
 
+ /** subRubyStall {{{
+  * @brief Request backtrace of running call, async-signal-safe
+  **/
+
+void
+subRubyStall(void)
+{
+#if defined HAVE_RB_POSTPONED_JOB_PREREGISTER
+  if(POSTPONED_JOB_HANDLE_INVALID != stalljob)
+    rb_postponed_job_trigger(stalljob);
+#elif defined HAVE_RB_POSTPONED_JOB_REGISTER_ONE
+  rb_postponed_job_register_one(0, RubyStallBacktrace, NULL);
+#endif /* HAVE_RB_POSTPONED_JOB_PREREGISTER */
+} /* }}} */
+
  /** subRubyRelease {{{
   * @brief Release value from shelter
   * @param[in]  value  The released value
@@ -59,8 +59,6 @@ ScreenPublish(void)
   free(panels);
   free(viewports);
 
-  XSync(subtle->dpy, False); ///< Sync all changes
-
   subSubtleLogDebugSubtle("Publish: screens=%d\n",
     subtle->screens->ndata);
 } /* }}} */
@@ -68,12 +66,14 @@ ScreenPublish(void)
 /* ScreenClear {{{ */
 static void
 ScreenClear(SubScreen *s,
-  unsigned long col)
+  unsigned long col,
+  int x,
+  int width)
 {
   /* Clear pixmap */
   XSetForeground(subtle->dpy, subtle->gcs.draw, col);
   XFillRectangle(subtle->dpy, s->drawable, subtle->gcs.draw,
-    0, 0, s->base.width, subtle->ph);
+    x, 0, width, subtle->ph);
 
    /* Draw stipple on panels */
   if(s->flags & SUB_SCREEN_STIPPLE)
@@ -84,10 +84,158 @@ ScreenClear(SubScreen *s,
       XChangeGC(subtle->dpy, subtle->gcs.stipple, GCStipple, &gvals);
 
       XFillRectangle(subtle->dpy, s->drawable, subtle->gcs.stipple,
-        0, 0, s->base.width, subtle->ph);
+        x, 0, width, subtle->ph);
+    }
+} /* }}} */
+
+/* ScreenExtent {{{ */
+static void
+ScreenExtent(SubPanel *p,
+  int *x,
+  int *width)
+{
+  *x     = p->x;
+  *width = p->width;
+
+  /* Add separators around panel item */
+  if(subtle->styles.separator.separator)
+    {
+      if(p->flags & SUB_PANEL_SEPARATOR1)
+        {
+          *x     -= subtle->styles.separator.separator->width;
+          *width += subtle->styles.separator.separator->width;
+        }
+
+      if(p->flags & SUB_PANEL_SEPARATOR2)
+        {
+          SubStyle *s = p->flags & SUB_PANEL_SUBLET &&
+            subtle->styles.subletsep ? subtle->styles.subletsep :
+            &subtle->styles.separator;
+
+          *width += s->separator->width;
+        }
+    }
+} /* }}} */
+
+/* ScreenRenderPanel {{{ */
+static void
+ScreenRenderPanel(SubScreen *s,
+  int start,
+  int end,
+  Window panel,
+  unsigned long col,
+  int full)
+{
+  int j, x = 0, width = 0, x1 = 0, x2 = s->base.width;
+
+  /* Collect damaged area of changed items */
+  if(!full)
+    {
+      x1 = s->base.width;
+      x2 = 0;
+
+      for(j = start; j < end; j++)
+        {
+          SubPanel *p = PANEL(s->panels->data[j]);
+
+          if(p->flags & SUB_PANEL_HIDDEN) x = width = 0;
+          else ScreenExtent(p, &x, &width);
+
+          /* Damage old and new area when moved or resized */
+          if(x != p->rx || width != p->rwidth)
+            {
+              if(0 < p->rwidth)
+                {
+                  x1 = MIN(x1, p->rx);
+                  x2 = MAX(x2, p->rx + p->rwidth);
+                }
+              if(0 < width)
+                {
+                  x1 = MIN(x1, x);
+                  x2 = MAX(x2, x + width);
+                }
+            }
+          else if(0 < width && (p->flags & SUB_PANEL_DIRTY ||
+              (p->flags & SUB_PANEL_SUBLET &&
+              p->sublet->flags & SUB_SUBLET_DIRTY)))
+            {
+              x1 = MIN(x1, x);
+              x2 = MAX(x2, x + width);
+            }
+        }
+
+      x1 = MAX(x1, 0);
+      x2 = MIN(x2, s->base.width);
+    }
+
+  /* Redraw items in damaged area and copy it */
+  if(x1 < x2)
+    {
+      ScreenClear(s, col, x1, x2 - x1);
+
+      for(j = start; j < end; j++)
+        {
+          SubPanel *p = PANEL(s->panels->data[j]);
+
+          if(p->flags & SUB_PANEL_HIDDEN) continue;
+
+          ScreenExtent(p, &x, &width);
+
+          if(x < x2 && x + width > x1) subPanelRender(p, s->drawable);
+        }
+
+      XCopyArea(subtle->dpy, s->drawable, panel, subtle->gcs.draw,
+        x1, 0, x2 - x1, subtle->ph, x1, 0);
+    }
+
+  /* Store rendered area */
+  for(j = start; j < end; j++)
+    {
+      SubPanel *p = PANEL(s->panels->data[j]);
+
+      if(p->flags & SUB_PANEL_HIDDEN) p->rx = p->rwidth = 0;
+      else ScreenExtent(p, &p->rx, &p->rwidth);
+
+      p->flags &= ~SUB_PANEL_DIRTY;
     }
 } /* }}} */
 
+/* ScreenRender {{{ */
+static void
+ScreenRender(int full)
+{
+  int i, j;
+  unsigned long start = subStatsTime();
+
+  /* Render all screens */
+  for(i = 0; i < subtle->screens->ndata; i++)
+    {
+      SubScreen *s = SCREEN(subtle->screens->data[i]);
+      int npanels = s->panels ? s->panels->ndata : 0;
+
+      /* Find first item of bottom panel */
+      for(j = 0; j < npanels; j++)
+        if(PANEL(s->panels->data[j])->flags & SUB_PANEL_BOTTOM) break;
+
+      ScreenRenderPanel(s, 0, j, s->panel1,
+        subtle->styles.subtle.top, full);
+
+      if(j < npanels)
+        {
+          ScreenRenderPanel(s, j, npanels, s->panel2,
+            subtle->styles.subtle.bottom, full);
+        }
+    }
+
+  /* Sublets are shared, so reset them after all screens */
+  for(i = 0; i < subtle->sublets->ndata; i++)
+    PANEL(subtle->sublets->data[i])->sublet->flags &= ~SUB_SUBLET_DIRTY;
+
+  subStatsRender(start);
+
+  subSubtleLogDebugSubtle("Render: full=%d\n", full);
+} /* }}} */
+
 /* Public */
 
  /** subScreenInit {{{
@@ -306,12 +454,25 @@ subScreenConfigure(void)
   subtle->visible_views = 0;
   subtle->client_tags   = 0;
 
-  /* Either check each client or just get visible clients */
+  /* Check views of each screen */
+  for(i = 0; i < subtle->screens->ndata; i++)
+    {
+      s = SCREEN(subtle->screens->data[i]);
+      v = VIEW(subtle->views->data[s->viewid]);
+
+      /* Set visible tags and views to ease lookups */
+      subtle->visible_tags  |= v->tags;
+      subtle->visible_views |= (1L << (s->viewid + 1));
+    }
+
+  /* Move clients between tile members before anything is arranged */
+  subClientSyncMembers();
+
+  /* Check each client */
   if(0 < subtle->clients->ndata)
     {
       int j;
 
-      /* Check each client */
       for(i = 0; i < subtle->clients->ndata; i++)
         {
           SubClient *c = CLIENT(subtle->clients->data[i]);
@@ -329,10 +490,6 @@ subScreenConfigure(void)
               s = SCREEN(subtle->screens->data[j]);
               v = VIEW(subtle->views->data[s->viewid]);
 
-              /* Set visible tags and views to ease lookups */
-              subtle->visible_tags  |= v->tags;
-              subtle->visible_views |= (1L << (s->viewid + 1));
-
               /* Find visible clients */
               if(VISIBLETAGS(c, v->tags))
                 {
@@ -358,8 +515,13 @@ subScreenConfigure(void)
             {
               /* Update client */
               subClientArrange(c, gravityid, screenid);
-              XMapWindow(subtle->dpy, c->win);
-              subEwmhSetWMState(c->win, NormalState);
+
+              if(NormalState != c->state)
+                {
+                  XMapWindow(subtle->dpy, c->win);
+                  subEwmhSetWMState(c->win, NormalState);
+                  c->state = NormalState;
+                }
 
               /* Warp after gravity and screen have been set if not disabled */
               if(c->flags & SUB_CLIENT_MODE_URGENT &&
@@ -368,32 +530,29 @@ subScreenConfigure(void)
                 subClientWarp(c);
 
               /* EWMH: Desktop, screen */
-              subEwmhSetCardinals(c->win, SUB_EWMH_NET_WM_DESKTOP,
-                (long *)&viewid, 1);
-              subEwmhSetCardinals(c->win, SUB_EWMH_SUBTLE_CLIENT_SCREEN,
-                (long *)&screenid, 1);
+              if(c->sentview != viewid)
+                {
+                  subEwmhSetCardinals(c->win, SUB_EWMH_NET_WM_DESKTOP,
+                    (long *)&viewid, 1);
+                  c->sentview = viewid;
+                }
+
+              if(c->sentscreen != screenid)
+                {
+                  subEwmhSetCardinals(c->win, SUB_EWMH_SUBTLE_CLIENT_SCREEN,
+                    (long *)&screenid, 1);
+                  c->sentscreen = screenid;
+                }
             }
-          else ///< Unmap other windows
+          else if(WithdrawnState != c->state) ///< Unmap other windows
             {
               c->flags |= SUB_CLIENT_UNMAP; ///< Ignore next unmap
               subEwmhSetWMState(c->win, WithdrawnState);
               XUnmapWindow(subtle->dpy, c->win);
+              c->state = WithdrawnState;
             }
         }
     }
-  else
-    {
-      /* Check views of each screen */
-      for(i = 0; i < subtle->screens->ndata; i++)
-        {
-          s = SCREEN(subtle->screens->data[i]);
-          v = VIEW(subtle->views->data[s->viewid]);
-
-          /* Set visible tags and views to ease lookups */
-          subtle->visible_tags  |= v->tags;
-          subtle->visible_views |= (1L << (s->viewid + 1));
-        }
-    }
 
   /* EWMH: Visible tags, views */
   subEwmhSetCardinals(ROOT, SUB_EWMH_SUBTLE_VISIBLE_TAGS,
@@ -401,7 +560,11 @@ subScreenConfigure(void)
   subEwmhSetCardinals(ROOT, SUB_EWMH_SUBTLE_VISIBLE_VIEWS,
     (long *)&subtle->visible_views, 1);
 
-  XSync(subtle->dpy, False); ///< Sync before going on
+  /* Arrange screens with view layouts once */
+  for(i = 0; i < subtle->screens->ndata; i++)
+    subLayoutDirty(i);
+
+  subLayoutFlush();
 
   /* Hook: Configure */
   subHookCall(SUB_HOOK_TILE, NULL);
@@ -544,41 +707,45 @@ subScreenUpdate(void)
 void
 subScreenRender(void)
 {
-  int i, j;
+  ScreenRender(True);
+} /* }}} */
 
-  /* Render all screens */
-  for(i = 0; i < subtle->screens->ndata; i++)
-    {
-      SubScreen *s = SCREEN(subtle->screens->data[i]);
-      Window panel = s->panel1;
+ /** subScreenDirty {{{
+  * @brief Mark screens for deferred update and/or render
+  * @param[in]  flags  Dirty flags
+  **/
 
-      ScreenClear(s, subtle->styles.subtle.top);
+void
+subScreenDirty(int flags)
+{
+  /* Update always implies full render */
+  if(flags & SUB_SUBTLE_UPDATE) flags |= SUB_SUBTLE_RENDER;
 
-      /* Render panel items */
-      for(j = 0; s->panels && j < s->panels->ndata; j++)
-        {
-          SubPanel *p = PANEL(s->panels->data[j]);
+  subtle->flags |= (flags & (SUB_SUBTLE_UPDATE|SUB_SUBTLE_RENDER|
+    SUB_SUBTLE_DAMAGE));
 
-          if(p->flags & SUB_PANEL_HIDDEN) continue;
-          if(panel != s->panel2 && p->flags & SUB_PANEL_BOTTOM)
-            {
-              XCopyArea(subtle->dpy, s->drawable, panel, subtle->gcs.draw,
-                0, 0, s->base.width, subtle->ph, 0, 0);
+  /* Flush immediately when not inside of the event loop */
+  if(!(subtle->flags & SUB_SUBTLE_RUN)) subScreenFlush();
+} /* }}} */
 
-              ScreenClear(s, subtle->styles.subtle.bottom);
-              panel = s->panel2;
-            }
+ /** subScreenFlush {{{
+  * @brief Update and render dirty screens once
+  **/
 
-          subPanelRender(p, s->drawable);
-        }
+void
+subScreenFlush(void)
+{
+  int flags = subtle->flags & (SUB_SUBTLE_UPDATE|SUB_SUBTLE_RENDER|
+    SUB_SUBTLE_DAMAGE);
 
-      XCopyArea(subtle->dpy, s->drawable, panel, subtle->gcs.draw,
-        0, 0, s->base.width, subtle->ph, 0, 0);
-    }
+  /* Clear first, update might mark screens dirty again */
+  subtle->flags &= ~(SUB_SUBTLE_UPDATE|SUB_SUBTLE_RENDER|SUB_SUBTLE_DAMAGE);
 
-  XSync(subtle->dpy, False); ///< Sync before going on
+  /* Damaged items may have changed their width */
+  if(flags & (SUB_SUBTLE_UPDATE|SUB_SUBTLE_DAMAGE)) subScreenUpdate();
 
-  subSubtleLogDebugSubtle("Render\n");
+  if(flags & SUB_SUBTLE_RENDER) ScreenRender(True);
+  else if(flags & SUB_SUBTLE_DAMAGE) ScreenRender(False);
 } /* }}} */
 
  /** subScreenResize {{{
@@ -716,8 +883,6 @@ subScreenPublish(void)
 
   free(views);
 
-  XSync(subtle->dpy, False); ///< Sync all changes
-
   subSubtleLogDebugSubtle("Publish: screens=%d\n",
     subtle->screens->ndata);
 } /* }}} */
@@ -0,0 +1,405 @@
+
+ /**
+  * @package subtle
+  *
+  * @file State functions
+  * @copyright (c) 2005-2013 Christoph Kappel <unexist@subforge.org>
+  * @version $Id$
+  *
+  * This program can be distributed under the terms of the GNU GPLv2.
+  * See the file COPYING for details.
+  **/
+
+#include <unistd.h>
+#include <X11/Xresource.h>
+#include "subtle.h"
+
+#define MAGIC "SUBSTA3"                          ///< File magic and version
+
+/* Typedef {{{ */
+typedef struct substatehead_t
+{
+  char          magic[8];                        ///< State magic
+  int           ntags, nviews, nscreens;         ///< State tags, views and screens
+  int           ngravities;                      ///< State gravities
+  int           nclients, nsublets;              ///< State clients and sublets
+} SubStateHead;
+
+typedef struct substateclient_t
+{
+  Window        win;                             ///< State client window
+  TAGS          tags;                            ///< State client tags
+  FLAGS         modes;                           ///< State client modes
+  int           screenid, *gravities;            ///< State client screen and gravities
+} SubStateClient;
+/* }}} */
+
+/* Globals */
+SubStateHead statehead;
+SubStateClient *stateclients = NULL;
+Window *staterecent = NULL;
+int *stateviews = NULL, nstateclients = 0, nstaterecent = 0;
+
+/* StatePath {{{ */
+static char *
+StatePath(void)
+{
+  char *dir = NULL, buf[100] = { 0 };
+
+  /* Only hand over state in a private runtime dir */
+  if(!(dir = getenv("XDG_RUNTIME_DIR")) || '\0' == *dir) return NULL;
+
+  /* Pid stays the same across exec */
+  snprintf(buf, sizeof(buf), "%s/subtle-%d.state", dir, (int)getpid());
+
+  return strdup(buf);
+} /* }}} */
+
+/* StateWriteName {{{ */
+static void
+StateWriteName(FILE *fd,
+  char *name)
+{
+  int len = name ? strlen(name) : 0;
+
+  fwrite(&len, sizeof(int), 1, fd);
+  fwrite(name, sizeof(char), len, fd);
+} /* }}} */
+
+/* StateCheckName {{{ */
+static int
+StateCheckName(FILE *fd,
+  char *name)
+{
+  int len = 0, ret = False;
+  char *buf = NULL;
+
+  if(1 != fread(&len, sizeof(int), 1, fd) || 0 > len || 1024 < len)
+    return False;
+
+  buf = (char *)subSharedMemoryAlloc(len + 1, sizeof(char));
+
+  if(len == fread(buf, sizeof(char), len, fd))
+    ret = (0 == strcmp(buf, name ? name : ""));
+
+  free(buf);
+
+  return ret;
+} /* }}} */
+
+/* StateFree {{{ */
+static void
+StateFree(void)
+{
+  int i;
+
+  for(i = 0; i < nstateclients; i++)
+    free(stateclients[i].gravities);
+
+  if(stateclients) free(stateclients);
+  if(stateviews)   free(stateviews);
+  if(staterecent)  free(staterecent);
+
+  stateclients  = NULL;
+  stateviews    = NULL;
+  staterecent   = NULL;
+  nstateclients = 0;
+  nstaterecent  = 0;
+} /* }}} */
+
+/* Public */
+
+ /** subStateSave {{{
+  * @brief Save state of clients, screens and sublets for restart
+  **/
+
+void
+subStateSave(void)
+{
+  int i, nrecent = 0;
+  char *path = NULL;
+  FILE *fd = NULL;
+  Window *recent = NULL;
+  time_t now = subSubtleTime();
+  SubStateHead head;
+
+  if(!(path = StatePath())) return;
+
+  if(!(fd = fopen(path, "wb")))
+    {
+      subSubtleLogError("Cannot open state file `%s'\n", path);
+      free(path);
+
+      return;
+    }
+
+  /* Header */
+  memset(&head, 0, sizeof(SubStateHead));
+  strncpy(head.magic, MAGIC, sizeof(head.magic));
+
+  head.ntags      = subtle->tags->ndata;
+  head.nviews     = subtle->views->ndata;
+  head.nscreens   = subtle->screens->ndata;
+  head.ngravities = subtle->gravities->ndata;
+  head.nclients   = subtle->clients->ndata;
+  head.nsublets   = subtle->sublets->ndata;
+
+  fwrite(&head, sizeof(SubStateHead), 1, fd);
+
+  /* Tag, view and gravity names to detect config changes */
+  for(i = 0; i < subtle->tags->ndata; i++)
+    StateWriteName(fd, TAG(subtle->tags->data[i])->name);
+
+  for(i = 0; i < subtle->views->ndata; i++)
+    StateWriteName(fd, VIEW(subtle->views->data[i])->name);
+
+  for(i = 0; i < subtle->gravities->ndata; i++)
+    StateWriteName(fd,
+      XrmQuarkToString(GRAVITY(subtle->gravities->data[i])->quark));
+
+  /* Screens */
+  for(i = 0; i < subtle->screens->ndata; i++)
+    fwrite(&SCREEN(subtle->screens->data[i])->viewid, sizeof(int), 1, fd);
+
+  /* Clients */
+  for(i = 0; i < subtle->clients->ndata; i++)
+    {
+      SubClient *c = CLIENT(subtle->clients->data[i]);
+      FLAGS modes = (c->flags & MODES_ALL);
+
+      fwrite(&c->win,      sizeof(Window), 1, fd);
+      fwrite(&c->tags,     sizeof(TAGS),   1, fd);
+      fwrite(&modes,       sizeof(FLAGS),  1, fd);
+      fwrite(&c->screenid, sizeof(int),    1, fd);
+      fwrite(c->gravities, sizeof(int), subtle->views->ndata, fd);
+    }
+
+  /* Whole focus history from most to least recent */
+  recent = subClientRecentList(&nrecent);
+
+  fwrite(&nrecent, sizeof(int),    1,       fd);
+  fwrite(recent,   sizeof(Window), nrecent, fd);
+
+  free(recent);
+
+  /* Sublets: Remaining time until next run */
+  for(i = 0; i < subtle->sublets->ndata; i++)
+    {
+      SubPanel *p = PANEL(subtle->sublets->data[i]);
+      time_t remain = 0;
+
+      if(p->sublet->flags & SUB_SUBLET_INTERVAL && p->sublet->time > now)
+        remain = p->sublet->time - now;
+
+      StateWriteName(fd, p->sublet->name);
+      fwrite(&remain, sizeof(time_t), 1, fd);
+    }
+
+  fclose(fd);
+
+  subSubtleLogDebugSubtle("Save: file=%s, clients=%d\n", path, head.nclients);
+
+  free(path);
+} /* }}} */
+
+ /** subStateLoad {{{
+  * @brief Load state of previous instance if any
+  **/
+
+void
+subStateLoad(void)
+{
+  int i, valid = False;
+  char *path = NULL;
+  FILE *fd = NULL;
+
+  if(!(path = StatePath())) return;
+
+  if(!(fd = fopen(path, "rb")))
+    {
+      free(path);
+
+      return;
+    }
+
+  /* Check whether config still matches */
+  if(1 == fread(&statehead, sizeof(SubStateHead), 1, fd) &&
+      0 == strncmp(statehead.magic, MAGIC, sizeof(statehead.magic)) &&
+      statehead.ntags == subtle->tags->ndata &&
+      statehead.nviews == subtle->views->ndata &&
+      statehead.ngravities == subtle->gravities->ndata &&
+      0 <= statehead.nscreens && 0 <= statehead.nclients &&
+      0 <= statehead.nsublets)
+    {
+      valid = True;
+
+      for(i = 0; valid && i < statehead.ntags; i++)
+        valid = StateCheckName(fd, TAG(subtle->tags->data[i])->name);
+
+      for(i = 0; valid && i < statehead.nviews; i++)
+        valid = StateCheckName(fd, VIEW(subtle->views->data[i])->name);
+
+      for(i = 0; valid && i < statehead.ngravities; i++)
+        valid = StateCheckName(fd,
+          XrmQuarkToString(GRAVITY(subtle->gravities->data[i])->quark));
+    }
+
+  if(valid)
+    {
+      /* Screens */
+      stateviews = (int *)subSharedMemoryAlloc(statehead.nscreens + 1,
+        sizeof(int));
+
+      valid = (statehead.nscreens == fread(stateviews, sizeof(int),
+        statehead.nscreens, fd));
+
+      /* Clients */
+      stateclients = (SubStateClient *)subSharedMemoryAlloc(
+        statehead.nclients + 1, sizeof(SubStateClient));
+
+      for(i = 0; valid && i < statehead.nclients; i++)
+        {
+          SubStateClient *sc = &stateclients[i];
+
+          sc->gravities = (int *)subSharedMemoryAlloc(statehead.nviews + 1,
+            sizeof(int));
+          nstateclients++;
+
+          valid = (1 == fread(&sc->win,      sizeof(Window), 1, fd) &&
+            1 == fread(&sc->tags,     sizeof(TAGS),  1, fd) &&
+            1 == fread(&sc->modes,    sizeof(FLAGS), 1, fd) &&
+            1 == fread(&sc->screenid, sizeof(int),   1, fd) &&
+            statehead.nviews == fread(sc->gravities, sizeof(int),
+              statehead.nviews, fd));
+        }
+
+      /* Focus history, every entry is a client */
+      if(valid && (1 != fread(&nstaterecent, sizeof(int), 1, fd) ||
+          0 > nstaterecent || statehead.nclients < nstaterecent))
+        {
+          nstaterecent = 0;
+          valid        = False;
+        }
+
+      staterecent = (Window *)subSharedMemoryAlloc(nstaterecent + 1,
+        sizeof(Window));
+
+      if(valid) valid = (nstaterecent == fread(staterecent, sizeof(Window),
+        nstaterecent, fd));
+
+      /* Sublets: Restore timers of known sublets */
+      for(i = 0; valid && i < statehead.nsublets; i++)
+        {
+          int j, len = 0;
+          char buf[256] = { 0 };
+          time_t remain = 0;
+
+          if(1 != fread(&len, sizeof(int), 1, fd) || 0 > len ||
+              sizeof(buf) <= len || len != fread(buf, sizeof(char), len, fd) ||
+              1 != fread(&remain, sizeof(time_t), 1, fd))
+            break;
+
+          for(j = 0; 0 < remain && j < subtle->sublets->ndata; j++)
+            {
+              SubPanel *p = PANEL(subtle->sublets->data[j]);
+
+              if(p->sublet->flags & SUB_SUBLET_INTERVAL &&
+                  0 == strcmp(p->sublet->name, buf))
+                {
+                  subEventTimerAt(p, subSubtleTime() + remain);
+                  break;
+                }
+            }
+        }
+    }
+
+  fclose(fd);
+  unlink(path); ///< State is only valid once
+
+  /* Fall back to retagging everything */
+  if(!valid) StateFree();
+
+  subSubtleLogDebugSubtle("Load: file=%s, valid=%d\n", path, valid);
+
+  free(path);
+} /* }}} */
+
+ /** subStateClient {{{
+  * @brief Restore client state of previous instance
+  * @param[in]     c      A #SubClient
+  * @param[inout]  flags  Mode flags
+  * @return Returns \p True when client was restored
+  **/
+
+int
+subStateClient(SubClient *c,
+  int *flags)
+{
+  int i;
+
+  assert(c && flags);
+
+  for(i = 0; i < nstateclients; i++)
+    {
+      SubStateClient *sc = &stateclients[i];
+
+      if(sc->win == c->win)
+        {
+          int j;
+
+          /* Ids must fit the current config, otherwise retag */
+          if(0 > sc->screenid || sc->screenid >= subtle->screens->ndata)
+            return False;
+
+          for(j = 0; j < subtle->views->ndata; j++)
+            if(0 > sc->gravities[j] ||
+                sc->gravities[j] >= subtle->gravities->ndata)
+              return False;
+
+          c->tags      = sc->tags;
+          c->screenid  = sc->screenid;
+          *flags      |= sc->modes;
+
+          memcpy(c->gravities, sc->gravities, subtle->views->ndata * sizeof(int));
+
+          /* EWMH: Tags */
+          subEwmhSetCardinals(c->win, SUB_EWMH_SUBTLE_CLIENT_TAGS,
+            (long *)&c->tags, 1);
+
+          return True;
+        }
+    }
+
+  return False;
+} /* }}} */
+
+ /** subStateFinish {{{
+  * @brief Restore screens and focus history and drop state
+  **/
+
+void
+subStateFinish(void)
+{
+  int i;
+  SubClient *c = NULL;
+
+  /* Restore screen views and focus history */
+  if(stateviews)
+    {
+      for(i = 0; i < statehead.nscreens && i < subtle->screens->ndata; i++)
+        if(0 <= stateviews[i] && stateviews[i] < subtle->views->ndata)
+          SCREEN(subtle->screens->data[i])->viewid = stateviews[i];
+
+      /* Oldest first, so the last focus ends up as head and sets
+       * the focus windows */
+      for(i = nstaterecent - 1; 0 <= i; i--)
+        if((c = CLIENT(subSubtleFind(staterecent[i], CLIENTID))))
+          subClientRecent(c);
+    }
+
+  StateFree();
+
+  subSubtleLogDebugSubtle("Finish\n");
+} /* }}} */
+
+// vim:ts=2:bs=2:sw=2:et:fdm=marker
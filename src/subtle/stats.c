@@ -0,0 +1,408 @@
+
+ /**
+  * @package subtle
+  *
+  * @file Stats functions
+  * @copyright (c) 2005-2013 Christoph Kappel <unexist@subforge.org>
+  * @version $Id$
+  *
+  * This program can be distributed under the terms of the GNU GPLv2.
+  * See the file COPYING for details.
+  **/
+
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <strings.h>
+#include <sys/time.h>
+#include "subtle.h"
+
+#define NBUCKETS 20                              ///< Log2 buckets of usec
+#define NCALLS   9                               ///< Number of call types
+#define NROWS    (LASTEvent + NCALLS + 2)        ///< Events, calls, render and ahead
+#define NSTALLS  8                               ///< Max depth of watched handlers
+
+/* Typedef {{{ */
+typedef struct substatsrow_t
+{
+  unsigned long count, total, max, buckets[NBUCKETS];
+} SubStatsRow;
+
+typedef struct substatsstall_t
+{
+  int           id, flagged, quiet;              ///< Stall row id and state
+  const char    *name;                           ///< Stall sublet name
+  unsigned long start;                           ///< Stall start in usec
+} SubStatsStall;
+/* }}} */
+
+/* Globals */
+SubStatsRow rows[NROWS], *stallrows = NULL;
+SubStatsStall stalls[NSTALLS];
+char **stallnames = NULL;
+int nstallrows = 0;
+volatile sig_atomic_t nstalls = 0, stallarmed = False;
+
+/* StatsName {{{ */
+static const char *
+StatsName(int id)
+{
+  const char *names[] =
+  {
+    NULL, NULL, "KeyPress", "KeyRelease", "ButtonPress", "ButtonRelease",
+    "MotionNotify", "EnterNotify", "LeaveNotify", "FocusIn", "FocusOut",
+    "KeymapNotify", "Expose", "GraphicsExpose", "NoExpose",
+    "VisibilityNotify", "CreateNotify", "DestroyNotify", "UnmapNotify",
+    "MapNotify", "MapRequest", "ReparentNotify", "ConfigureNotify",
+    "ConfigureRequest", "GravityNotify", "ResizeRequest",
+    "CirculateNotify", "CirculateRequest", "PropertyNotify",
+    "SelectionClear", "SelectionRequest", "SelectionNotify",
+    "ColormapNotify", "ClientMessage", "MappingNotify", "GenericEvent",
+
+    /* Ruby calls */
+    "call:hooks", "call:configure", "call:run", "call:data", "call:watch",
+    "call:down", "call:over", "call:out", "call:unload",
+
+    /* Panels */
+    "render",
+
+    /* Input */
+    "ahead"
+  };
+
+  return id < LENGTH(names) ? names[id] : NULL;
+} /* }}} */
+
+/* StatsRecord {{{ */
+static void
+StatsRecord(SubStatsRow *r,
+  unsigned long elapsed)
+{
+  int bucket = 0;
+
+  /* Find log2 bucket */
+  while(bucket < NBUCKETS - 1 && (elapsed >> (bucket + 1)))
+    bucket++;
+
+  r->count++;
+  r->total += elapsed;
+  r->buckets[bucket]++;
+
+  if(elapsed > r->max) r->max = elapsed;
+} /* }}} */
+
+/* StatsFormat {{{ */
+static char *
+StatsFormat(const char *prefix,
+  const char *name,
+  SubStatsRow *r)
+{
+  int i, len = 0, size = 0;
+  char *buf = NULL;
+
+  /* Name, count, total, max and all buckets */
+  size = 64 + strlen(name) + (NBUCKETS * 21);
+  buf  = (char *)subSharedMemoryAlloc(size, sizeof(char));
+  len  = snprintf(buf, size, "%s%s %lu %lu %lu ", prefix, name,
+    r->count, r->total, r->max);
+
+  for(i = 0; i < NBUCKETS && len < size; i++)
+    len += snprintf(buf + len, size - len, "%s%lu",
+      0 == i ? "" : ",", r->buckets[i]);
+
+  return buf;
+} /* }}} */
+
+/* StatsArm {{{ */
+static void
+StatsArm(void)
+{
+  struct itimerval it;
+
+  memset(&it, 0, sizeof(struct itimerval));
+
+  it.it_value.tv_sec  = subtle->budget / 1000;
+  it.it_value.tv_usec = (subtle->budget % 1000) * 1000;
+
+  stallarmed = True;
+  setitimer(ITIMER_REAL, &it, NULL);
+} /* }}} */
+
+/* StatsWrite {{{ */
+static void
+StatsWrite(const char *str)
+{
+  /* Async-signal-safe output */
+  if(str && -1 == write(STDOUT_FILENO, str, strlen(str)))
+    return;
+} /* }}} */
+
+/* StatsStallRecord {{{ */
+static void
+StatsStallRecord(SubStatsStall *st,
+  unsigned long elapsed)
+{
+  int i;
+  const char *name = st->name ? st->name : StatsName(st->id);
+
+  /* Find or add named row */
+  for(i = 0; i < nstallrows; i++)
+    if(0 == strcmp(stallnames[i], name)) break;
+
+  if(i == nstallrows)
+    {
+      stallrows  = (SubStatsRow *)subSharedMemoryRealloc(stallrows,
+        (nstallrows + 1) * sizeof(SubStatsRow));
+      stallnames = (char **)subSharedMemoryRealloc(stallnames,
+        (nstallrows + 1) * sizeof(char *));
+
+      memset(&stallrows[i], 0, sizeof(SubStatsRow));
+      stallnames[i] = strdup(name);
+      nstallrows++;
+    }
+
+  StatsRecord(&stallrows[i], elapsed);
+} /* }}} */
+
+/* Stats */
+
+ /** subStatsTime {{{
+  * @brief Get monotonic time in usec for stats
+  * @return Time in usec
+  **/
+
+unsigned long
+subStatsTime(void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+
+  if(0 == clock_gettime(CLOCK_MONOTONIC, &ts))
+    return ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+#endif /* CLOCK_MONOTONIC */
+
+  struct timeval tv;
+
+  gettimeofday(&tv, 0);
+
+  return tv.tv_sec * 1000000UL + tv.tv_usec;
+} /* }}} */
+
+ /** subStatsEvent {{{
+  * @brief Record handler latency of X event
+  * @param[in]  type   X event type
+  * @param[in]  start  Start time from #subStatsTime
+  **/
+
+void
+subStatsEvent(int type,
+  unsigned long start)
+{
+  if(0 <= type && type < LASTEvent)
+    StatsRecord(&rows[type], subStatsTime() - start);
+} /* }}} */
+
+ /** subStatsCall {{{
+  * @brief Record latency of ruby call
+  * @param[in]  type   Call type
+  * @param[in]  start  Start time from #subStatsTime
+  **/
+
+void
+subStatsCall(int type,
+  unsigned long start)
+{
+  int idx = ffs(type) - ffs(SUB_CALL_HOOKS);
+
+  if(0 <= idx && idx < NCALLS)
+    StatsRecord(&rows[LASTEvent + idx], subStatsTime() - start);
+} /* }}} */
+
+ /** subStatsRender {{{
+  * @brief Record latency of panel render
+  * @param[in]  start  Start time from #subStatsTime
+  **/
+
+void
+subStatsRender(unsigned long start)
+{
+  StatsRecord(&rows[LASTEvent + NCALLS], subStatsTime() - start);
+} /* }}} */
+
+ /** subStatsAhead {{{
+  * @brief Record latency of press that overtook queued events
+  * @param[in]  start  Start time from #subStatsTime
+  **/
+
+void
+subStatsAhead(unsigned long start)
+{
+  StatsRecord(&rows[LASTEvent + NCALLS + 1], subStatsTime() - start);
+} /* }}} */
+
+ /** subStatsPublish {{{
+  * @brief Publish stats as root property
+  * @param[in]  dump  Whether to print stats to stdout
+  **/
+
+void
+subStatsPublish(int dump)
+{
+  int i, nlist = 0;
+  char **list = NULL;
+
+  list = (char **)subSharedMemoryAlloc(NROWS + nstallrows, sizeof(char *));
+
+  /* Collect rows with data */
+  for(i = 0; i < NROWS; i++)
+    {
+      if(0 < rows[i].count && StatsName(i))
+        {
+          list[nlist] = StatsFormat("", StatsName(i), &rows[i]);
+
+          if(dump) printf("%s\n", list[nlist]);
+
+          nlist++;
+        }
+    }
+
+  /* Add stalls */
+  for(i = 0; i < nstallrows; i++)
+    {
+      list[nlist] = StatsFormat("stall:", stallnames[i], &stallrows[i]);
+
+      if(dump) printf("%s\n", list[nlist]);
+
+      nlist++;
+    }
+
+  /* EWMH: Stats */
+  subSharedPropertySetStrings(subtle->dpy, ROOT,
+    subEwmhGet(SUB_EWMH_SUBTLE_STATS), list, nlist);
+  XFlush(subtle->dpy);
+
+  for(i = 0; i < nlist; i++)
+    free(list[i]);
+  free(list);
+
+  subSubtleLogDebugSubtle("Publish: stats=%d\n", nlist);
+} /* }}} */
+
+/* Stall */
+
+ /** subStatsStallEnter {{{
+  * @brief Enter watched handler
+  * @param[in]  type  X event type or call type
+  * @param[in]  call  Whether type is a call type
+  * @param[in]  name  Sublet name or \p NULL
+  **/
+
+void
+subStatsStallEnter(int type,
+  int call,
+  const char *name)
+{
+  if(nstalls < NSTALLS)
+    {
+      SubStatsStall *st = &stalls[nstalls];
+
+      st->id      = call ? LASTEvent + ffs(type) - ffs(SUB_CALL_HOOKS) : type;
+      st->name    = name;
+      st->flagged = False;
+      st->quiet   = False;
+      st->start   = subStatsTime();
+
+      /* Ignore unknown types */
+      if(!StatsName(st->id)) st->id = 0;
+    }
+
+  nstalls++;
+
+  /* Arm watchdog lazily, it disarms itself once idle */
+  if(!stallarmed && 0 < subtle->budget) StatsArm();
+} /* }}} */
+
+ /** subStatsStallLeave {{{
+  * @brief Leave watched handler
+  * @return Returns \p True when the handler stalled
+  **/
+
+int
+subStatsStallLeave(void)
+{
+  int ret = False;
+
+  if(0 >= nstalls) return False;
+
+  if(--nstalls < NSTALLS && stalls[nstalls].flagged)
+    {
+      SubStatsStall *st = &stalls[nstalls];
+      unsigned long elapsed = subStatsTime() - st->start;
+
+      StatsStallRecord(st, elapsed);
+
+      /* Only report the innermost stalled handler */
+      if(!st->quiet)
+        {
+          subSubtleLogWarn("Stall: %s%s%s took %lums (budget %dms)\n",
+            StatsName(st->id) ? StatsName(st->id) : "handler",
+            st->name ? " of sublet " : "", st->name ? st->name : "",
+            elapsed / 1000, subtle->budget);
+        }
+
+      if(0 < nstalls && nstalls <= NSTALLS) stalls[nstalls - 1].quiet = True;
+
+      ret = True;
+    }
+
+  return ret;
+} /* }}} */
+
+ /** subStatsStallAlarm {{{
+  * @brief Check watched handlers for stalls, called from signal handler
+  **/
+
+void
+subStatsStallAlarm(void)
+{
+  int i, depth = MIN(nstalls, NSTALLS), reported = False;
+  unsigned long now = subStatsTime();
+
+  stallarmed = False;
+
+  if(0 == depth || 0 >= subtle->budget) return; ///< Idle
+
+  /* Flag all handlers that exceed the budget */
+  for(i = depth - 1; 0 <= i; i--)
+    {
+      SubStatsStall *st = &stalls[i];
+
+      if(!st->flagged && now - st->start >= subtle->budget * 1000UL)
+        {
+          st->flagged = True;
+
+          if(!reported)
+            {
+              StatsWrite("<WARNING> Stall: ");
+              StatsWrite(StatsName(st->id) ? StatsName(st->id) : "handler");
+
+              if(st->name)
+                {
+                  StatsWrite(" of sublet ");
+                  StatsWrite(st->name);
+                }
+
+              StatsWrite(" exceeds budget\n");
+
+              /* Ask ruby for a backtrace of the innermost call */
+              if(depth - 1 == i && LASTEvent <= st->id) subRubyStall();
+
+              reported = True;
+            }
+        }
+    }
+
+  StatsArm(); ///< Keep watching while busy
+} /* }}} */
+
+// vim:ts=2:bs=2:sw=2:et:fdm=marker
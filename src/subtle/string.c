@@ -0,0 +1,228 @@
+
+ /**
+  * @package subtle
+  *
+  * @file String functions
+  * @copyright (c) 2005-2013 Christoph Kappel <unexist@subforge.org>
+  * @version $Id$
+  *
+  * This program can be distributed under the terms of the GNU GPLv2.
+  * See the file COPYING for details.
+  **/
+
+#include <stddef.h>
+#include "subtle.h"
+
+#define MINBUCKETS 64                            ///< Initial number of buckets
+#define ENTRY(s) ((StringEntry *)((s) - offsetof(StringEntry, str)))
+
+/* Typedef {{{ */
+typedef struct stringmatch_t
+{
+  regex_t *regex;                                ///< Match regex
+  int     match;                                 ///< Match result
+} StringMatch;
+
+typedef struct stringentry_t
+{
+  struct stringentry_t *next;                    ///< Next entry in bucket
+  unsigned int         hash;                     ///< Entry hash
+  int                  refs, nmatches;           ///< Entry refs, matches
+  StringMatch          *matches;                 ///< Entry match cache
+  char                 str[];                    ///< Entry string
+} StringEntry;
+/* }}} */
+
+/* Globals */
+StringEntry **buckets = NULL;
+unsigned int nbuckets = 0, nentries = 0;
+
+/* Private */
+
+/* StringHash {{{ */
+static unsigned int
+StringHash(const char *str)
+{
+  unsigned int hash = 2166136261u;
+
+  /* FNV-1a */
+  while(*str)
+    {
+      hash ^= (unsigned char)*str++;
+      hash *= 16777619u;
+    }
+
+  return hash;
+} /* }}} */
+
+/* StringGrow {{{ */
+static void
+StringGrow(void)
+{
+  unsigned int i, size = nbuckets ? nbuckets * 2 : MINBUCKETS;
+  StringEntry **grown = NULL;
+
+  grown = (StringEntry **)subSharedMemoryAlloc(size, sizeof(StringEntry *));
+
+  /* Rehash entries, size is always a power of two */
+  for(i = 0; i < nbuckets; i++)
+    {
+      StringEntry *e = buckets[i], *next = NULL;
+
+      for(; e; e = next)
+        {
+          next = e->next;
+
+          e->next                     = grown[e->hash & (size - 1)];
+          grown[e->hash & (size - 1)] = e;
+        }
+    }
+
+  if(buckets) free(buckets);
+
+  buckets  = grown;
+  nbuckets = size;
+} /* }}} */
+
+/* Public */
+
+ /** subStringIntern {{{
+  * @brief Get shared copy of string
+  * @param[in]  str  String to intern
+  * @return Returns interned string or \p NULL
+  **/
+
+char *
+subStringIntern(const char *str)
+{
+  unsigned int hash = 0;
+  size_t len = 0;
+  StringEntry *e = NULL;
+
+  if(!str) return NULL;
+
+  hash = StringHash(str);
+
+  /* Check for existing entry */
+  if(buckets)
+    {
+      for(e = buckets[hash & (nbuckets - 1)]; e; e = e->next)
+        {
+          if(e->hash == hash && 0 == strcmp(e->str, str))
+            {
+              e->refs++;
+
+              return e->str;
+            }
+        }
+    }
+
+  /* Keep load factor below one */
+  if(nentries >= nbuckets) StringGrow();
+
+  len = strlen(str);
+  e   = (StringEntry *)subSharedMemoryAlloc(1, sizeof(StringEntry) + len + 1);
+
+  e->hash = hash;
+  e->refs = 1;
+  memcpy(e->str, str, len + 1);
+
+  e->next                        = buckets[hash & (nbuckets - 1)];
+  buckets[hash & (nbuckets - 1)] = e;
+  nentries++;
+
+  subSubtleLogDebugSubtle("Intern: str=%s, entries=%u\n", str, nentries);
+
+  return e->str;
+} /* }}} */
+
+ /** subStringMatch {{{
+  * @brief Check if interned string matches regex and cache result
+  * @param[in]  str    Interned string
+  * @param[in]  regex  Regex to match
+  * @retval  True   String matches
+  * @retval  False  String doesn't match
+  **/
+
+int
+subStringMatch(char *str,
+  regex_t *regex)
+{
+  int i;
+  StringEntry *e = NULL;
+
+  assert(str && regex);
+
+  e = ENTRY(str);
+
+  /* Check cached results */
+  for(i = 0; i < e->nmatches; i++)
+    if(e->matches[i].regex == regex) return e->matches[i].match;
+
+  e->matches = (StringMatch *)subSharedMemoryRealloc(e->matches,
+    (e->nmatches + 1) * sizeof(StringMatch));
+
+  e->matches[e->nmatches].regex = regex;
+  e->matches[e->nmatches].match = subSharedRegexMatch(regex, str);
+
+  return e->matches[e->nmatches++].match;
+} /* }}} */
+
+ /** subStringFlush {{{
+  * @brief Drop all cached match results
+  **/
+
+void
+subStringFlush(void)
+{
+  unsigned int i;
+
+  /* Regexes may be reused after free, results must go with them */
+  for(i = 0; i < nbuckets; i++)
+    {
+      StringEntry *e = NULL;
+
+      for(e = buckets[i]; e; e = e->next)
+        {
+          if(e->matches) free(e->matches);
+
+          e->matches  = NULL;
+          e->nmatches = 0;
+        }
+    }
+} /* }}} */
+
+ /** subStringRelease {{{
+  * @brief Release interned string
+  * @param[in]  str  Interned string
+  **/
+
+void
+subStringRelease(char *str)
+{
+  StringEntry *e = NULL, **prev = NULL;
+
+  if(!str) return;
+
+  e = ENTRY(str);
+
+  if(0 < --e->refs) return;
+
+  /* Unlink from bucket */
+  for(prev = &buckets[e->hash & (nbuckets - 1)]; *prev; prev = &(*prev)->next)
+    {
+      if(*prev == e)
+        {
+          *prev = e->next;
+
+          break;
+        }
+    }
+
+  if(e->matches) free(e->matches);
+  free(e);
+
+  nentries--;
+} /* }}} */
+
+// vim:ts=2:bs=2:sw=2:et:fdm=marker
@@ -14,6 +14,7 @@
 #include <getopt.h>
 #include <sys/wait.h>
 #include <sys/time.h>
+#include <time.h>
 #include <signal.h>
 #include <unistd.h>
 #include "subtle.h"
@@ -33,6 +34,8 @@ SubtleSignal(int signum)
       case SIGCHLD: wait(NULL);                                    break;
       case SIGHUP:  if(subtle) subtle->flags |= SUB_SUBTLE_RELOAD; break;
       case SIGINT:  if(subtle) subtle->flags &= ~SUB_SUBTLE_RUN;   break;
+      case SIGUSR1: if(subtle) subtle->flags |= SUB_SUBTLE_STATS;  break;
+      case SIGALRM: if(subtle) subStatsStallAlarm();                break;
       case SIGSEGV:
           {
 #ifdef HAVE_EXECINFO_H
@@ -71,6 +74,8 @@ SubtleUsage(void)
          "  -n, --no-randr             Disable RandR extension (required for Twinview)\n" \
          "  -r, --replace              Replace current window manager\n" \
          "  -s, --sublets=DIR          Load sublets from DIR\n" \
+         "  -R, --record=FILE          Record X events to FILE\n" \
+         "  -P, --replay=FILE          Replay X events from FILE and exit\n" \
          "  -v, --version              Show version info and exit\n" \
          "  -l, --level=LEVEL[,LEVEL]  Set logging levels\n" \
          "  -D, --debug                Print debugging messages\n" \
@@ -149,18 +154,36 @@ subSubtleFind(Window win,
 } /* }}} */
 
  /** subSubtleTime {{{
-  * @brief Get the current time in seconds
-  * @return Returns time in seconds
+  * @brief Get the current monotonic time in milliseconds
+  * @return Returns time in milliseconds
   **/
 
 time_t
 subSubtleTime(void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+
+  if(0 == clock_gettime(CLOCK_MONOTONIC, &ts))
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif /* CLOCK_MONOTONIC */
+
+  return subSubtleWallTime();
+} /* }}} */
+
+ /** subSubtleWallTime {{{
+  * @brief Get the current wall clock time in milliseconds
+  * @return Returns time in milliseconds
+  **/
+
+time_t
+subSubtleWallTime(void)
 {
   struct timeval tv;
 
   gettimeofday(&tv, 0);
 
-  return tv.tv_sec;
+  return tv.tv_sec * 1000 + tv.tv_usec / 1000;
 } /* }}} */
 
  /** subSubtleLog {{{
@@ -226,6 +249,10 @@ subSubtleFinish(void)
       if(subtle->dpy)
         XSync(subtle->dpy, False); ///< Sync before going on
 
+      /* Hand over state to next instance */
+      if(subtle->flags & SUB_SUBTLE_RESTART && subtle->clients)
+        subStateSave();
+
       /* Handle hooks first */
       if(subtle->hooks)
         {
@@ -256,6 +283,7 @@ subSubtleFinish(void)
       subStyleReset(&subtle->styles.clients,   0);
       subStyleReset(&subtle->styles.subtle,    0);
 
+      subRecordFinish();
       subEventFinish();
       subRubyFinish();
       subEwmhFinish();
@@ -282,6 +310,8 @@ main(int argc,
     { "no-randr", no_argument,       0, 'n' },
     { "replace",  no_argument,       0, 'r' },
     { "sublets",  required_argument, 0, 's' },
+    { "record",   required_argument, 0, 'R' },
+    { "replay",   required_argument, 0, 'P' },
     { "version",  no_argument,       0, 'v' },
     { "level",    required_argument, 0, 'l' },
     { "debug",    no_argument,       0, 'D' },
@@ -292,9 +322,11 @@ main(int argc,
   subtle = (SubSubtle *)(subSharedMemoryAlloc(1, sizeof(SubSubtle)));
   subtle->flags    |= (SUB_SUBTLE_XRANDR|SUB_SUBTLE_XINERAMA);
   subtle->loglevel  = DEFAULT_LOGLEVEL;
+  subtle->expiry    = QUEUEEXPIRY;
+  subtle->budget    = STALLBUDGET;
 
   /* Parse arguments */
-  while(-1 != (c = getopt_long(argc, argv, "c:d:hknrs:vl:D",
+  while(-1 != (c = getopt_long(argc, argv, "c:d:hknrs:R:P:vl:D",
       long_options, NULL)))
     {
       switch(c)
@@ -306,6 +338,14 @@ main(int argc,
           case 'n': subtle->flags &= ~SUB_SUBTLE_XRANDR;  break;
           case 'r': subtle->flags |= SUB_SUBTLE_REPLACE;  break;
           case 's': subtle->paths.sublets = optarg;       break;
+          case 'R':
+            subtle->paths.record  = optarg;
+            subtle->flags        |= SUB_SUBTLE_RECORD;
+            break;
+          case 'P':
+            subtle->paths.record  = optarg;
+            subtle->flags        |= SUB_SUBTLE_REPLAY;
+            break;
           case 'v': SubtleVersion();                      return 0;
 #ifdef DEBUG
           case 'l':
@@ -337,6 +377,11 @@ main(int argc,
   sigaction(SIGINT,  &sa, NULL);
   sigaction(SIGSEGV, &sa, NULL);
   sigaction(SIGCHLD, &sa, NULL);
+  sigaction(SIGUSR1, &sa, NULL);
+
+  /* Stall watchdog must not break blocking calls */
+  sa.sa_flags = SA_RESTART;
+  sigaction(SIGALRM, &sa, NULL);
 
   /* Load and check config only */
   if(subtle->flags & SUB_SUBTLE_CHECK)
@@ -361,6 +406,13 @@ main(int argc,
   subtle->trays     = subArrayNew();
   subtle->views     = subArrayNew();
 
+  /* Elements of these arrays store their index */
+  subtle->clients->indexed = True;
+  subtle->grabs->indexed   = True;
+  subtle->screens->indexed = True;
+  subtle->tags->indexed    = True;
+  subtle->views->indexed   = True;
+
   /* Init */
   SubtleVersion();
   subDisplayInit(display);
@@ -376,7 +428,9 @@ main(int argc,
 
   /* Display */
   subDisplayConfigure();
+  subStateLoad();
   subDisplayScan();
+  subStateFinish();
 
   subEventLoop();
 
@@ -51,6 +51,9 @@
 #define MINH         1L                                           ///< Client min height
 #define WAITTIME     10                                           ///< Max waiting time
 #define HISTORYSIZE  5                                            ///< Size of the focus history
+#define QUEUESIZE    32                                           ///< Size of the message queues
+#define QUEUEEXPIRY  10000                                        ///< Default queue expiry in ms
+#define STALLBUDGET  1000                                         ///< Default stall budget in ms
 #define DEFAULTTAG   (1L << 1)                                    ///< Default tag
 
 #define GRAVITYSTRLIMIT 1                                         ///< Gravity string limit to ignore \0
@@ -98,7 +101,7 @@
 #define VISIBLE(C) VISIBLETAGS(C,subtle->visible_tags)            ///< Whether client is visible
 
 #define VISIBLETAGS(C,Tags) \
-  (C && (Tags & c->tags || \
+  (C && (Tags & C->tags || \
   C->flags & (SUB_CLIENT_TYPE_DESKTOP|SUB_CLIENT_MODE_STICK)))    ///< Whether client is visible on tags
 
 #define ROOT DefaultRootWindow(subtle->dpy)                       ///< Root window
@@ -152,6 +155,7 @@
 #define ARRAY(a)     ((SubArray *)a)                              ///< Cast to SubArray
 #define CHAIN(c)     ((SubChain *)c)                              ///< Cast to SubChain
 #define CLIENT(c)    ((SubClient *)c)                             ///< Cast to SubClient
+#define ELEM(e)      ((SubArrayElem *)e)                          ///< Cast to SubArrayElem
 #define GRAB(g)      ((SubGrab *)g)                               ///< Cast to SubGrab
 #define GRAVITY(g)   ((SubGravity *)g)                            ///< Cast to SubGravity
 #define HOOK(h)      ((SubHook *)h)                               ///< Cast to SubHook
@@ -278,6 +282,7 @@
 #define SUB_GRAB_DIRECTION_RIGHT      (1L << 1)                   ///< Direction right
 #define SUB_GRAB_DIRECTION_DOWN       (1L << 2)                   ///< Direction down
 #define SUB_GRAB_DIRECTION_LEFT       (1L << 3)                   ///< Direction left
+#define SUB_GRAB_DIRECTION_RECENT     (1L << 4)                   ///< Direction focus history
 
 /* Gravity flags */
 #define SUB_GRAVITY_HORZ              (1L << 10)                  ///< Gravity tile gravity horizontally
@@ -304,6 +309,7 @@
 #define SUB_PANEL_DOWN                (1L << 25)                  ///< Panel mouse down
 #define SUB_PANEL_OVER                (1L << 26)                  ///< Panel mouse over
 #define SUB_PANEL_OUT                 (1L << 27)                  ///< Panel mouse out
+#define SUB_PANEL_DIRTY               (1L << 28)                  ///< Panel content changed
 
 /* Sublet flags */
 #define SUB_SUBLET_INTERVAL           (1L << 10)                  ///< Sublet has interval
@@ -314,11 +320,14 @@
 #define SUB_SUBLET_DATA               (1L << 14)                  ///< Sublet data function
 #define SUB_SUBLET_WATCH              (1L << 15)                  ///< Sublet watch function
 #define SUB_SUBLET_UNLOAD             (1L << 16)                  ///< Sublet unload function
+#define SUB_SUBLET_DIRTY              (1L << 17)                  ///< Sublet content changed
+#define SUB_SUBLET_PENDING            (1L << 18)                  ///< Sublet watch pending
 
 /* Screen flags */
 #define SUB_SCREEN_PANEL1             (1L << 10)                  ///< Screen sanel1 enabled
 #define SUB_SCREEN_PANEL2             (1L << 11)                  ///< Screen sanel2 enabled
 #define SUB_SCREEN_STIPPLE            (1L << 12)                  ///< Screen stipple enabled
+#define SUB_SCREEN_LAYOUT             (1L << 13)                  ///< Screen layout dirty
 
 /* Style flags */
 #define SUB_STYLE_FONT                (1L << 10)                  ///< Style has custom font
@@ -341,6 +350,16 @@
 #define SUB_SUBTLE_FOCUS_CLICK        (1L << 13)                  ///< Click to focus
 #define SUB_SUBTLE_SKIP_WARP          (1L << 14)                  ///< Skip pointer warp
 #define SUB_SUBTLE_SKIP_URGENT_WARP   (1L << 15)                  ///< Skip urgent warp
+#define SUB_SUBTLE_UPDATE             (1L << 16)                  ///< Panel update pending
+#define SUB_SUBTLE_RENDER             (1L << 17)                  ///< Panel render pending
+#define SUB_SUBTLE_DAMAGE             (1L << 18)                  ///< Panel damage pending
+#define SUB_SUBTLE_SPREAD             (1L << 19)                  ///< Spread sublet timers
+#define SUB_SUBTLE_STATS              (1L << 20)                  ///< Stats dump pending
+#define SUB_SUBTLE_RECORD             (1L << 21)                  ///< Record events
+#define SUB_SUBTLE_REPLAY             (1L << 22)                  ///< Replay events
+#define SUB_SUBTLE_SCAN               (1L << 23)                  ///< Startup scan
+#define SUB_SUBTLE_STACKING           (1L << 24)                  ///< Stacking list pending
+#define SUB_SUBTLE_OPAQUE             (1L << 25)                  ///< Opaque window drag
 
 /* Tag flags */
 #define SUB_TAG_GRAVITY               (1L << 10)                  ///< Gravity property
@@ -432,10 +451,16 @@
 /* Typedefs {{{ */
 typedef struct subarray_t /* {{{ */
 {
-  int   ndata;                                                    ///< Array data count
+  int   ndata, indexed;                                           ///< Array data count, whether elements store their index
   void **data;                                                    ///< Array data
 } SubArray; /* }}} */
 
+typedef struct subarrayelem_t /* {{{ */
+{
+  FLAGS flags;                                                    ///< Element flags
+  int   idx;                                                      ///< Element index in indexed array
+} SubArrayElem; /* }}} */
+
 typedef struct subkeychain_t /* {{{ */
 {
   int              len;                                           ///< Keychain length
@@ -445,7 +470,8 @@ typedef struct subkeychain_t /* {{{ */
 typedef struct subclient_t /* {{{ */
 {
   FLAGS      flags;                                               ///< Client flags
-  char       *name, *instance, *klass, *role;                     ///< Client instance, klass
+  int        idx;                                                 ///< Client index in client list
+  char       *name, *instance, *klass, *role;                     ///< Client name, interned class
 
   TAGS       tags;                                                ///< Client tags
   Window     win, leader;                                         ///< Client window and leader
@@ -456,6 +482,12 @@ typedef struct subclient_t /* {{{ */
   int        minw, minh, maxw, maxh, incw, inch, basew, baseh;    ///< Client sizes
 
   int        dir, screenid, gravityid;                            ///< Client restacking dir, current screen id, current gravity id
+  int        memberid;                                            ///< Client tile member list id
+
+  XRectangle sent;                                                ///< Client geom last sent to server
+  struct subclient_t *mruprev, *mrunext;                          ///< Client focus history links
+  long       state;                                               ///< Client WM_STATE last set
+  int        sentview, sentscreen, sentgravity;                   ///< Client view, screen and gravity last published
   int        *gravities;                                          ///< Client gravities for views
 } SubClient; /* }}} */
 
@@ -564,6 +596,7 @@ typedef enum subewmh_t /* {{{ */
   SUB_EWMH_SUBTLE_COLORS,                                         ///< Subtle colors
   SUB_EWMH_SUBTLE_FONT,                                           ///< Subtle font
   SUB_EWMH_SUBTLE_DATA,                                           ///< Subtle data
+  SUB_EWMH_SUBTLE_STATS,                                          ///< Subtle stats
   SUB_EWMH_SUBTLE_VERSION,                                        ///< Subtle version
 
   SUB_EWMH_TOTAL
@@ -572,6 +605,7 @@ typedef enum subewmh_t /* {{{ */
 typedef struct subgrab_t /* {{{ */
 {
   FLAGS              flags;                                    ///< Grab flags
+  int                idx;                                      ///< Grab index in grab list
 
   unsigned int       code, state;                              ///< Grab code, stater
   union subdata_t    data;                                     ///< Grab data
@@ -603,6 +637,7 @@ typedef struct subpanel_t /* {{{ */
 {
   FLAGS                   flags;                                  ///< Panel flags
   int                     x, width;                               ///< Panel x, width
+  int                     rx, rwidth;                             ///< Panel rendered x, width
   struct subscreen_t      *screen;                                ///< Panel screen
 
   union {
@@ -615,6 +650,7 @@ typedef struct subpanel_t /* {{{ */
 typedef struct subscreen_t /* {{{ */
 {
   FLAGS             flags;                                        ///< Screen flags
+  int               idx;                                          ///< Screen index in screen list
 
   int               viewid;                                       ///< Screen current view id
   XRectangle        geom, base;                                   ///< Screen geom, base
@@ -636,9 +672,10 @@ typedef struct subseparator_t /* {{{ */
 typedef struct subsublet_t { /* {{{ */
   FLAGS             flags;                                        ///< Sublet flags
   int               watch, width, styleid;                        ///< Sublet watch id, width and style id
+  int               timer;                                        ///< Sublet timer queue index
   char              *name;                                        ///< Sublet name
   unsigned long     instance;                                     ///< Sublet ruby instance, fg, bg and icon color
-  time_t            time, interval;                               ///< Sublet update/interval time
+  time_t            time, interval;                               ///< Sublet update/interval time in ms
 
   struct subtext_t  *text;                                        ///< Sublet text
 } SubSublet; /* }}} */
@@ -666,6 +703,8 @@ typedef struct subsubtle_t /* {{{ */
 
   int                  loglevel, width, height;                   ///< Subtle loglevel and screen size
   int                  ph, step, snap;                            ///< Subtle properties
+  int                  expiry;                                    ///< Subtle queue expiry in ms
+  int                  budget;                                    ///< Subtle stall budget in ms
   int                  visible_tags, visible_views;               ///< Subtle visible tags and views
   int                  client_tags, urgent_tags;                  ///< Subtle clients and urgent tags
   unsigned long        gravity;                                   ///< Subtle default gravity
@@ -690,7 +729,7 @@ typedef struct subsubtle_t /* {{{ */
 
   struct
   {
-    char               *config, *sublets;                         ///< Subtle paths
+    char               *config, *sublets, *record;                ///< Subtle paths
   } paths;
 
   struct
@@ -726,6 +765,7 @@ typedef struct subsubtle_t /* {{{ */
 typedef struct subtag_t /* {{{ */
 {
   FLAGS             flags;                                        ///< Tag flags
+  int               idx;                                          ///< Tag index in tag list
   char              *name;                                        ///< Tag name
   unsigned long     gravityid, proc;                              ///< Tag gravity, proc
   int               screenid;                                     ///< Tag screen
@@ -759,10 +799,11 @@ typedef struct subtray_t /* {{{ */
 typedef struct subview_t /* {{{ */
 {
   FLAGS             flags;                                        ///< View flags
+  int               idx;                                          ///< View index in view list
   char              *name;                                        ///< View name
   TAGS              tags;                                         ///< View tags
   Window            focus;                                        ///< View window, focus
-  int               width, styleid;                               ///< View width, style id
+  int               width, styleid, layout;                       ///< View width, style id, layout id
 
   struct subicon_t  *icon;                                        ///< View icon
 } SubView; /* }}} */
@@ -785,17 +826,30 @@ void subArrayKill(SubArray *a, int clean);                        ///< Kill arra
 
 /* client.c {{{ */
 SubClient *subClientNew(Window win);                              ///< Create client
+void subClientPrefetch(Window *wins, int nwins);                  ///< Prefetch windows
+int subClientPrefetchState(Window win);                           ///< Get prefetched map state
+void subClientPrefetchFinish(void);                               ///< Drop prefetched windows
 void subClientConfigure(SubClient *c);                            ///< Send configure request
+int subClientMoveResize(SubClient *c, XRectangle *geom);          ///< Move and resize client
+void subClientPlace(SubClient *c, XRectangle *geom,
+  XRectangle *bounds);                                            ///< Place client in geometry
 void subClientDimension(int id);                                  ///< Dimension clients
 void subClientFocus(SubClient *c, int warp);                      ///< Focus client
 SubClient *subClientNext(int screenid, int jump);                 ///< Focus next client
 void subClientWarp(SubClient *c);                                 ///< Warp pointer to client
+SubClient *subClientSelect(SubClient *c, int direction);          ///< Find client in direction
+void subClientRecent(SubClient *c);                               ///< Move client to front of history
+Window *subClientRecentList(int *nwins);                          ///< Get focus history
+SubClient *subClientRecentNext(SubClient *c, int viewid,
+  int screenid);                                                  ///< Find next client in history
+SubClient *subClientRecentCycle(int viewid, int screenid);        ///< Cycle through history
 void subClientDrag(SubClient *c, int mode, int direction);        ///< Move/drag client
 void subClientUpdate(int vid);                                    ///< Update clients
 void subClientTag(SubClient *c, int tag, int *flags);             ///< Tag client
 void subClientRetag(SubClient *c, int *flags);                    ///< Update client tags
 void subClientResize(SubClient *c, XRectangle *bounds,
   int size_hints);                                                ///< Resize client for screen
+void subClientSyncMembers(void);                                  ///< Sync tile members
 void subClientRestack(SubClient *c, int dir);                     ///< Restack clients
 void subClientArrange(SubClient *c, int gravityid,
   int screenid);                                                  ///< Arrange client
@@ -811,19 +865,25 @@ void subClientSetType(SubClient *c, int *flags);                  ///< Set clien
 void subClientClose(SubClient *c);                                ///< Close client
 void subClientKill(SubClient *c);                                 ///< Kill client
 void subClientPublish(int restack);                               ///< Publish all clients
+void subClientPublishStacking(void);                              ///< Publish client stacking
 /* }}} */
 
 /* display.c {{{ */
 void subDisplayInit(const char *display);                         ///< Create display
 void subDisplayConfigure(void);                                   ///< Configure display
 void subDisplayScan(void);                                        ///< Scan root window
+void subDisplayTrack(Window win);                                 ///< Track requests of window
 void subDisplayPublish(void);                                     ///< Publish colors
 void subDisplayFinish(void);                                      ///< Kill display
 /* }}} */
 
 /* event.c {{{ */
-void subEventWatchAdd(int fd);                                    ///< Add watch fd
+void subEventDispatch(XEvent *ev);                                ///< Dispatch event
+void subEventWatchAdd(int fd, void *data);                        ///< Add watch fd
 void subEventWatchDel(int fd);                                    ///< Del watch fd
+void subEventTimerAdd(SubPanel *p);                               ///< Add/update sublet timer
+void subEventTimerDel(SubPanel *p);                               ///< Del sublet timer
+void subEventTimerAt(SubPanel *p, time_t time);                   ///< Schedule sublet timer at time
 void subEventLoop(void);                                          ///< Event loop
 void subEventFinish(void);                                        ///< Finish events
 /* }}} */
@@ -875,11 +935,17 @@ void subHookCall(int type, void *data);                           ///< Call hook
 void subHookKill(SubHook *h);                                     ///< Kill hook
 /* }}} */
 
+/* layout.c {{{ */
+int subLayoutFind(const char *name);                              ///< Find layout id
+int subLayoutDirty(int screenid);                                 ///< Mark screen for layout
+void subLayoutFlush(void);                                        ///< Apply marked layouts
+/* }}} */
+
 /* panel.c {{{ */
 SubPanel *subPanelNew(int type);                                  ///< Create new panel
 void subPanelUpdate(SubPanel *p);                                 ///< Update panels
 void subPanelRender(SubPanel *p, Drawable drawable);              ///< Render panels
-int subPanelCompare(const void *a, const void *b);                ///< Compare two panels
+void subPanelDamage(SubPanel *p);                                 ///< Mark panel damaged
 void subPanelAction(SubArray *panels, int type, int x, int y,
   int button, int bottom);                                        ///< Handle panel action
 void subPanelGeometry(SubPanel *p, SubStyle *s,
@@ -897,10 +963,18 @@ void subRubyUnloadSublet(SubPanel *p);                            ///< Unload su
 void subRubyLoadSublets(void);                                    ///< Load sublets
 void subRubyLoadPanels(void);                                     ///< Load panels
 int subRubyCall(int type, unsigned long proc, void *data);        ///< Call Ruby script
+void subRubyStall(void);                                          ///< Request stall backtrace
 int subRubyRelease(unsigned long recv);                           ///< Release receiver
 void subRubyFinish(void);                                         ///< Kill Ruby stack
 /* }}} */
 
+/* record.c {{{ */
+void subRecordInit(void);                                         ///< Init record/replay
+void subRecordEvent(XEvent *ev);                                  ///< Record event
+int subRecordReplay(void);                                        ///< Replay due records
+void subRecordFinish(void);                                       ///< Finish record/replay
+/* }}} */
+
 /* screen.c {{{ */
 void subScreenInit(void);                                         ///< Init screens
 SubScreen *subScreenNew(int x, int y, unsigned int width,
@@ -910,6 +984,8 @@ SubScreen * subScreenCurrent(int *sid);                           ///< Get curre
 void subScreenConfigure(void);                                    ///< Configure screens
 void subScreenUpdate(void);                                       ///< Update screens
 void subScreenRender(void);                                       ///< Render screens
+void subScreenDirty(int flags);                                   ///< Mark screens dirty
+void subScreenFlush(void);                                        ///< Flush dirty screens
 void subScreenResize(void);                                       ///< Update screen sizes
 void subScreenWarp(SubScreen *s);                                 ///< Warp pointer to screen
 void subScreenPublish(void);                                      ///< Publish screens
@@ -925,9 +1001,36 @@ void subStyleKill(SubStyle *s);                                   ///< Kill styl
 void subStyleUpdate(void);                                        ///< Update values
 /* }}} */
 
+/* state.c {{{ */
+void subStateSave(void);                                          ///< Save state for restart
+void subStateLoad(void);                                          ///< Load state of restart
+int subStateClient(SubClient *c, int *flags);                     ///< Restore client state
+void subStateFinish(void);                                        ///< Restore rest and drop state
+/* }}} */
+
+/* stats.c {{{ */
+unsigned long subStatsTime(void);                                 ///< Get stats time in usec
+void subStatsEvent(int type, unsigned long start);                ///< Record event latency
+void subStatsCall(int type, unsigned long start);                 ///< Record call latency
+void subStatsRender(unsigned long start);                         ///< Record render latency
+void subStatsAhead(unsigned long start);                          ///< Record overtaking press
+void subStatsPublish(int dump);                                   ///< Publish stats
+void subStatsStallEnter(int type, int call, const char *name);    ///< Enter watched handler
+int subStatsStallLeave(void);                                     ///< Leave watched handler
+void subStatsStallAlarm(void);                                    ///< Check for stalls
+/* }}} */
+
+/* string.c {{{ */
+char *subStringIntern(const char *str);                           ///< Intern string
+int subStringMatch(char *str, regex_t *regex);                    ///< Check cached match
+void subStringFlush(void);                                        ///< Drop match cache
+void subStringRelease(char *str);                                 ///< Release string
+/* }}} */
+
 /* subtle.c {{{ */
 XPointer * subSubtleFind(Window win, XContext id);                ///< Find window
-time_t subSubtleTime(void);                                       ///< Get current time
+time_t subSubtleTime(void);                                       ///< Get monotonic time in ms
+time_t subSubtleWallTime(void);                                   ///< Get wall clock time in ms
 void subSubtleLog(int level, const char *file,
   int line, const char *format, ...);                             ///< Print messages
 void subSubtleFinish(void);                                       ///< Finish subtle
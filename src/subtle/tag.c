@@ -44,6 +44,9 @@ TagClear(SubTag *t)
     }
 
   subArrayClear(t->matcher, False);
+
+  /* Cached results refer to the killed regexes */
+  subStringFlush();
 } /* }}} */
 
 /* TagFind {{{ */
@@ -78,13 +81,13 @@ TagMatch(TagMatcher *m,
         subSharedRegexMatch(m->regex, c->name)) ||
       /* Check instance part of WM_CLASS */
       (m->flags & SUB_TAG_MATCH_INSTANCE && c->instance &&
-        subSharedRegexMatch(m->regex, c->instance)) ||
+        subStringMatch(c->instance, m->regex)) ||
       /* Check class part of WM_CLASS */
       (m->flags & SUB_TAG_MATCH_CLASS && c->klass &&
-        subSharedRegexMatch(m->regex, c->klass)) ||
+        subStringMatch(c->klass, m->regex)) ||
       /* Check WM_ROLE */
       (m->flags & SUB_TAG_MATCH_ROLE && c->role &&
-        subSharedRegexMatch(m->regex, c->role)))) ||
+        subStringMatch(c->role, m->regex)))) ||
       /* Check _NET_WM_WINDOW_TYPE */
       (m->flags & SUB_TAG_MATCH_TYPE &&
         c->flags & (m->flags & (SUB_CLIENT_TYPE_NORMAL|TYPES_ALL))))
@@ -274,8 +277,6 @@ subTagPublish(void)
   subSharedPropertySetStrings(subtle->dpy, ROOT,
     subEwmhGet(SUB_EWMH_SUBTLE_TAG_LIST), names, i);
 
-  XSync(subtle->dpy, False); ///< Sync all changes
-
   free(names);
 
   subSubtleLogDebugSubtle("Publish: tags=%d\n", i);
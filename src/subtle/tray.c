@@ -243,8 +243,7 @@ subTrayClose(SubTray *t)
       subTrayPublish();
       subTrayUpdate();
 
-      subScreenUpdate();
-      subScreenRender();
+      subScreenDirty(SUB_SUBTLE_UPDATE);
 
       /* Update focus if necessary */
       if(focus)
@@ -300,8 +299,6 @@ subTrayPublish(void)
   /* EWMH: Client list and client list stacking */
   subEwmhSetWindows(ROOT, SUB_EWMH_SUBTLE_TRAY_LIST, wins, subtle->trays->ndata);
 
-  XSync(subtle->dpy, False); ///< Sync all changes
-
   free(wins);
 
   subSubtleLogDebugSubtle("Publish: trays=%d\n", subtle->trays->ndata);
@@ -31,6 +31,7 @@ subViewNew(char *name,
   v = VIEW(subSharedMemoryAlloc(1, sizeof(SubView)));
   v->flags = SUB_TYPE_VIEW;
   v->styleid = -1;
+  v->layout  = -1;
   v->name  = strdup(name);
 
   /* Tags */
@@ -108,7 +109,7 @@ subViewFocus(SubView *v,
 
   /* Finally configure and render */
   subScreenConfigure();
-  subScreenRender();
+  subScreenDirty(SUB_SUBTLE_RENDER);
   subScreenPublish();
 
   /* Update focus */
@@ -118,7 +119,7 @@ subViewFocus(SubView *v,
       if(!((c = CLIENT(subSubtleFind(v->focus, CLIENTID))) &&
           VISIBLETAGS(c, v->tags)))
         {
-          c        = subClientNext(screenid, False);
+          c        = subClientRecentNext(NULL, vid, screenid);
           v->focus = None;
         }
 
@@ -196,8 +197,6 @@ subViewPublish(void)
       /* EWMH: Current desktop */
       subEwmhSetCardinals(ROOT, SUB_EWMH_NET_CURRENT_DESKTOP, &vid, 1);
 
-      XSync(subtle->dpy, False); ///< Sync all changes
-
       free(tags);
       free(icons);
       free(names);
@@ -9,6 +9,7 @@
   * See the file COPYING for details.
   **/
 
+#include <unistd.h>
 #include "subtlext.h"
 
 /* SubtleSend {{{ */
@@ -355,4 +356,95 @@ subextSubtleSingFont(VALUE self)
   return font;
 } /* }}} */
 
+/* subextSubtleSingStats {{{ */
+/*
+ * call-seq: stats -> Hash
+ *
+ * Get latency stats of the event loop of subtle. Each entry contains the
+ * count, total and max handler time in usec and a histogram of log2 usec
+ * buckets for either an X event type or a Ruby call type.
+ *
+ *  Subtlext::Subtle.stats
+ *  => { "MapRequest" => { :count => 3, :total => 612, :max => 301,
+ *       :buckets => [ 0, 0, 0, 0, 0, 0, 0, 1, 2, 0, ... ] } }
+ */
+
+VALUE
+subextSubtleSingStats(VALUE self)
+{
+  int i, nlist = 0;
+  char **list = NULL;
+  Window root = None;
+  Atom prop = None;
+  XEvent ev;
+  XWindowAttributes attrs;
+  VALUE hash = Qnil;
+
+  subextSubtlextConnect(NULL); ///< Implicit open connection
+
+  root = DefaultRootWindow(display);
+  prop = XInternAtom(display, "SUBTLE_STATS", False);
+
+  /* Watch root properties to catch the answer */
+  XGetWindowAttributes(display, root, &attrs);
+  XSelectInput(display, root, attrs.your_event_mask|PropertyChangeMask);
+
+  SubtleSend("SUBTLE_STATS");
+
+  /* Wait up to a second for subtle to publish stats */
+  for(i = 0; i < 100; i++)
+    {
+      if(XCheckTypedWindowEvent(display, root, PropertyNotify, &ev))
+        {
+          if(ev.xproperty.atom == prop) break;
+        }
+      else usleep(10000);
+    }
+
+  XSelectInput(display, root, attrs.your_event_mask);
+
+  /* Parse stats rows */
+  hash = rb_hash_new();
+
+  if((list = subSharedPropertyGetStrings(display, root, prop, &nlist)))
+    {
+      for(i = 0; i < nlist; i++)
+        {
+          int len = 0;
+          char name[64] = { 0 }, *tok = NULL, *end = NULL;
+          unsigned long count = 0, total = 0, max = 0;
+          VALUE row = Qnil, buckets = Qnil;
+
+          if(4 != sscanf(list[i], "%63s %lu %lu %lu %n", name,
+              &count, &total, &max, &len))
+            continue;
+
+          /* Collect buckets */
+          buckets = rb_ary_new();
+          tok     = list[i] + len;
+
+          while(*tok)
+            {
+              rb_ary_push(buckets, ULONG2NUM(strtoul(tok, &end, 10)));
+
+              if(end == tok) break;
+              tok = ',' == *end ? end + 1 : end;
+            }
+
+          row = rb_hash_new();
+
+          rb_hash_aset(row, CHAR2SYM("count"),   ULONG2NUM(count));
+          rb_hash_aset(row, CHAR2SYM("total"),   ULONG2NUM(total));
+          rb_hash_aset(row, CHAR2SYM("max"),     ULONG2NUM(max));
+          rb_hash_aset(row, CHAR2SYM("buckets"), buckets);
+
+          rb_hash_aset(hash, rb_str_new2(name), row);
+        }
+
+      XFreeStringList(list);
+    }
+
+  return hash;
+} /* }}} */
+
 // vim:ts=2:bs=2:sw=2:et:fdm=marker
@@ -21,6 +21,7 @@
 
 Display *display = NULL;
 VALUE mod = Qnil;
+static VALUE host = Qnil;
 
 /* SubtlextStringify {{{ */
 static void
@@ -1263,9 +1264,20 @@ subextSubtlextConnect(char *display_string)
 
       if(!setlocale(LC_CTYPE, "")) XSupportsLocale();
 
+      /* Check whether we are running inside of subtle */
+      if(rb_const_defined(rb_cObject, rb_intern("Subtle")))
+        {
+          VALUE subtle = rb_const_get(rb_cObject, rb_intern("Subtle"));
+
+          if(rb_respond_to(subtle, rb_intern("sync"))) host = subtle;
+        }
+
       /* Register sweeper */
       atexit(SubtlextSweep);
     }
+
+  /* Let subtle flush its own connection before we use ours */
+  if(!NIL_P(host)) rb_funcall(host, rb_intern("sync"), 0, NULL);
 } /* }}} */
 
   /** subextSubtlextBacktrace {{{
@@ -2120,6 +2132,7 @@ Init_subtlext(void)
   rb_define_singleton_method(subtle, "quit",          subextSubtleSingQuit,          0);
   rb_define_singleton_method(subtle, "colors",        subextSubtleSingColors,        0);
   rb_define_singleton_method(subtle, "font",          subextSubtleSingFont,          0);
+  rb_define_singleton_method(subtle, "stats",         subextSubtleSingStats,         0);
 
   /* Aliases */
   rb_define_alias(rb_singleton_class(subtle), "reload_config", "reload");
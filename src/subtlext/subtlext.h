@@ -202,6 +202,7 @@ VALUE subextSubtleSingRestart(VALUE self);                           ///< Restar
 VALUE subextSubtleSingQuit(VALUE self);                              ///< Quit subtle
 VALUE subextSubtleSingColors(VALUE self);                            ///< Get colors
 VALUE subextSubtleSingFont(VALUE self);                              ///< Get font
+VALUE subextSubtleSingStats(VALUE self);                             ///< Get stats
 /* }}} */
 
 /* subtlext.c {{{ */
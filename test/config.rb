@@ -0,0 +1,20 @@
+#
+# @package test
+#
+# @file Test config
+# @author Christoph Kappel <unexist@subforge.org>
+# @version $Id$
+#
+# This program can be distributed under the terms of the GNU GPLv2.
+# See the file COPYING for details.
+#
+
+# Shipped config
+instance_eval(File.read("../data/subtle.rb"), "../data/subtle.rb")
+
+# View with a built-in layout
+view "layout", "terms|default" do
+  layout :master
+end
+
+# vim:ts=2:bs=2:sw=2:et:fdm=marker
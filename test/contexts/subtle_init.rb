@@ -10,7 +10,8 @@
 #
 
 context 'Subtle - Init' do
-  COLORS_COUNT = 48
+  COLORS_COUNT  = 48
+  STATS_BUCKETS = 20
 
   asserts 'Check running' do # {{{
     Subtlext::Subtle.running?
@@ -36,6 +37,20 @@ context 'Subtle - Init' do
 
     1 == Subtlext::Client.all.size
   end # }}}
+
+  asserts 'Check stats' do # {{{
+    stats = Subtlext::Subtle.stats
+
+    # Rows of name, count, total, max and log2 buckets
+    stats.is_a?(Hash) and stats.has_key?('MapRequest') and
+      stats.all? { |name, row|
+        name.is_a?(String) and row[:count].is_a?(Integer) and
+          row[:total].is_a?(Integer) and row[:max] <= row[:total] and
+          row[:buckets].is_a?(Array) and
+          STATS_BUCKETS == row[:buckets].size and
+          row[:count] == row[:buckets].inject(0, :+)
+      }
+  end # }}}
 end
 
 # vim:ts=2:bs=2:sw=2:et:fdm=marker
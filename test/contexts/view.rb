@@ -10,7 +10,7 @@
 #
 
 context 'View' do
-  VIEW_COUNT = 4
+  VIEW_COUNT = 5
   VIEW_ID    = 0
   VIEW_NAME  = 'terms'
   VIEW_TAG   = :default
@@ -83,7 +83,7 @@ context 'View' do
 
     sleep 1
 
-    5 == Subtlext::View.all.size
+    VIEW_COUNT + 1 == Subtlext::View.all.size
   end # }}}
 
   asserts 'Switch views' do # {{{
@@ -125,6 +125,33 @@ context 'View' do
       1 == after and topic.has_tag?(VIEW_TAG)
   end # }}}
 
+  asserts 'Check layout' do # {{{
+    Subtlext::View.first('layout').jump
+    Subtlext::Subtle.spawn("#{find_executable0('xterm')} -display :10")
+
+    sleep 1
+
+    # Master on the left, stack on the right
+    master, stack = Subtlext::Client.all.sort_by { |c| c.geometry.x }
+    tiled         = (master.geometry.width > stack.geometry.width and
+      master.geometry.height == stack.geometry.height)
+    width         = master.geometry.width
+
+    # Floating leaves the whole screen to the master
+    stack.toggle_float
+
+    sleep 0.5
+
+    alone = master.geometry.width > width
+
+    stack.kill
+    topic.jump
+
+    sleep 1
+
+    tiled and alone and 1 == Subtlext::Client.all.size
+  end # }}}
+
   asserts 'Store values' do # {{{
     topic[:test] = 'test'
 
@@ -0,0 +1,89 @@
+#!/usr/bin/ruby
+#
+# @package test
+#
+# @file Check that presses overtake queued client requests
+# @author Christoph Kappel <unexist@subforge.org>
+# @version $Id$
+#
+# This program can be distributed under the terms of the GNU GPLv2.
+# See the file COPYING for details.
+#
+# Replays a crafted record: A stand-in client floods subtle with
+# configure requests and a key press is sent right behind them. Subtle
+# must handle the press ahead of the requests and count it in the ahead
+# row of the stats it prints when the replay is done.
+#
+
+require "mkmf"
+require "tempfile"
+
+# Configuration
+subtle  = "../subtle"
+config  = "../data/subtle.rb"
+sublets = "./sublet"
+display = ":10"
+
+# Event types and window kinds of the record format
+MAP_REQUEST       = 20
+CONFIGURE_REQUEST = 23
+UNMAP_NOTIFY      = 18
+KEY_PRESS         = 2
+KIND_NONE         = 0
+KIND_OWN          = 1
+KIND_CLIENT       = 2
+KIND_OTHER        = 4
+
+ROOT   = 0x100
+CLIENT = 0x1000001
+
+def record(time, type, flags, wins, kinds, data = []) # {{{
+  [ time, type, flags ].pack("Qii") + wins.pack("Q2") + kinds.pack("c2") +
+    [ data.size ].pack("i") + data.pack("q*") + [ 0, 0 ].pack("ii")
+end # }}}
+
+# Write record
+file = Tempfile.new("overtake")
+
+file.write([ "SUBREC2", ROOT, 0, 0, 0 ].pack("a8Q3ix4"))
+file.write(record(0, MAP_REQUEST, 0, [ CLIENT, 0 ], [ KIND_OTHER, KIND_NONE ]))
+
+100.times do |i|
+  file.write(record(500000, CONFIGURE_REQUEST, 0, [ CLIENT, 0 ],
+    [ KIND_CLIENT, KIND_NONE ], [ 0xf, i, i, 100 + i, 100 + i, 0, 0 ]))
+end
+
+file.write(record(500000, KEY_PRESS, 0, [ ROOT, 0 ], [ KIND_OWN, KIND_NONE ],
+  [ 0, 38, 0, 0, 0, 0, 0 ]))
+
+# Give subtle time to handle the queue before the replay ends
+file.write(record(1500000, UNMAP_NOTIFY, 1, [ CLIENT, 0 ],
+  [ KIND_CLIENT, KIND_NONE ]))
+file.close
+
+# Find Xvfb
+if (xvfb = find_executable0("Xvfb")).nil?
+  raise "Xvfb not found in path"
+end
+
+# Start Xvfb
+xpid = Process.spawn("#{xvfb} #{display} -screen 0 1024x768x16 -I",
+  [ :out, :err ] => "/dev/null")
+
+sleep 1
+
+# Run replay and check ahead row
+begin
+  output = `#{subtle} -d #{display} -c #{config} -s #{sublets} -P #{file.path}`
+  ahead  = output[/^ahead (\d+)/, 1].to_i
+
+  puts "Overtaken: #{ahead}"
+
+  exit(0 < ahead ? 0 : 1)
+ensure
+  Process.kill("TERM", xpid)
+  Process.wait(xpid)
+  file.unlink
+end
+
+# vim:ts=2:bs=2:sw=2:et:fdm=marker
@@ -0,0 +1,49 @@
+#!/usr/bin/ruby
+#
+# @package test
+#
+# @file Replay recorded X events against a fresh subtle
+# @author Christoph Kappel <unexist@subforge.org>
+# @version $Id$
+#
+# This program can be distributed under the terms of the GNU GPLv2.
+# See the file COPYING for details.
+#
+# Record a session with `subtle --record=FILE' and run it again with
+# `ruby replay.rb FILE'. Subtle prints handler stats, consumed cpu time
+# and the number of X requests once the replay is done.
+#
+
+require "mkmf"
+
+# Configuration
+subtle  = "../subtle"
+config  = "../data/subtle.rb"
+sublets = "./sublet"
+display = ":10"
+
+if (record = ARGV.shift).nil?
+  puts "Usage: replay.rb FILE"
+  exit
+end
+
+# Find Xvfb
+if (xvfb = find_executable0("Xvfb")).nil?
+  raise "Xvfb not found in path"
+end
+
+# Start Xvfb
+xpid = Process.spawn("#{xvfb} #{display} -screen 0 1024x768x16 -I",
+  [ :out, :err ] => "/dev/null")
+
+sleep 1
+
+# Run replay and wait for subtle to exit
+begin
+  system("#{subtle} -d #{display} -c #{config} -s #{sublets} -P #{record}")
+ensure
+  Process.kill("TERM", xpid)
+  Process.wait(xpid)
+end
+
+# vim:ts=2:bs=2:sw=2:et:fdm=marker
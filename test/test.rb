@@ -13,7 +13,7 @@
 # Configuration
 subtle   = "../subtle"
 subtlext = "../subtlext.so"
-config   = "../data/subtle.rb"
+config   = "./config.rb"
 sublets  = "./sublet"
 display  = ":10"
 